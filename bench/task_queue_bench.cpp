@@ -0,0 +1,149 @@
+// Enqueue/dequeue throughput of the threadpool queue with inline_task + task_queue
+// against the std::function + std::queue pool it replaced. Both pools below are
+// the same mutex/condition_variable design as threadpool and differ only in the
+// task and queue types. Heap allocations are counted through operator new.
+#include "inline_task.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+std::atomic<size_t> allocations{0};
+}
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+template<typename T>
+T take(std::queue<T>& queue) {
+    T task = std::move(queue.front());
+    queue.pop();
+    return task;
+}
+inline_task take(task_queue& queue) {
+    return queue.pop();
+}
+
+template<typename Task, typename Queue>
+class pool {
+public:
+    explicit pool(int workers) {
+        for (int i = 0; i < workers; ++i) {
+            threads_.emplace_back([this] { run(); });
+        }
+    }
+    ~pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& t : threads_) {
+            t.join();
+        }
+    }
+
+    template<typename F>
+    void enqueue(F&& f) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.emplace(std::forward<F>(f));
+        }
+        cv_.notify_one();
+    }
+    long done() const { return done_.load(std::memory_order_relaxed); }
+
+private:
+    void run() {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (stopping_ && queue_.empty()) {
+                    return;
+                }
+                task = take(queue_);
+            }
+            task();
+            done_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    Queue queue_;
+    bool stopping_ = false;
+    std::atomic<long> done_{0};
+};
+
+// Stands in for a closure carrying more than [client_fd, this]
+struct payload {
+    char bytes[40];
+};
+
+constexpr long tasks_per_run = 1000000;
+
+// backlog 0 lets the queue grow freely, otherwise the producer waits while more
+// than backlog tasks are outstanding (a steady state where the ring stops growing)
+template<typename Task, typename Queue, typename Make>
+void run(const char* name, Make make, int workers, long backlog) {
+    std::atomic<long> sink{0};
+    allocations.store(0, std::memory_order_relaxed);
+    auto begin = std::chrono::steady_clock::now();
+    {
+        pool<Task, Queue> p(workers);
+        for (long i = 0; i < tasks_per_run; ++i) {
+            while (backlog && i - p.done() > backlog) {
+                std::this_thread::yield();
+            }
+            p.enqueue(make(i, &sink));
+        }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    std::printf("%-38s backlog %-5ld %7.0f ms %7.2f Mtask/s %6.2f allocs/task\n", name, backlog, ms,
+                tasks_per_run / ms / 1000, static_cast<double>(allocations.load()) / tasks_per_run);
+}
+
+} // namespace
+
+int main() {
+    auto small = [](long i, std::atomic<long>* sink) {
+        return [i, sink] { sink->fetch_add(i, std::memory_order_relaxed); };
+    };
+    auto large = [](long i, std::atomic<long>* sink) {
+        payload extra{};
+        extra.bytes[0] = static_cast<char>(i);
+        return [i, sink, extra] { sink->fetch_add(i + extra.bytes[0], std::memory_order_relaxed); };
+    };
+    using function_task = std::function<void()>;
+    for (long backlog : {0L, 256L}) {
+        for (int workers : {1, 4}) {
+            std::printf("-- %d worker(s)\n", workers);
+            run<function_task, std::queue<function_task>>("std::function + std::queue, 16B", small, workers, backlog);
+            run<inline_task, task_queue>("inline_task + task_queue,   16B", small, workers, backlog);
+            run<function_task, std::queue<function_task>>("std::function + std::queue, 56B", large, workers, backlog);
+            run<inline_task, task_queue>("inline_task + task_queue,   56B", large, workers, backlog);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Mutex acquisitions per task for threadpool's enqueue() against enqueue_bulk()
+// under bursty load, as when the accept loop hands over a burst of connections.
+// pthread_mutex_lock is counted through -Wl,--wrap (see the Makefile); std::mutex
+// locks inline, so producer and worker sides are both included. Wakeups are not:
+// notify_one() calls pthread_cond_signal from inside libstdc++, out of --wrap's reach.
+#include "socket.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace {
+std::atomic<long> lock_calls{0};
+}
+
+extern "C" {
+int __real_pthread_mutex_lock(pthread_mutex_t* mutex);
+int __wrap_pthread_mutex_lock(pthread_mutex_t* mutex) {
+    lock_calls.fetch_add(1, std::memory_order_relaxed);
+    return __real_pthread_mutex_lock(mutex);
+}
+}
+
+namespace {
+
+constexpr long tasks_per_run = 1000000;
+constexpr int workers = 4;
+
+void run(int burst, bool bulk) {
+    std::atomic<long> done{0};
+    long locks_before;
+    double ms;
+    {
+        threadpool pool(workers);
+        std::vector<inline_task> batch;
+        batch.reserve(burst);
+        locks_before = lock_calls.load();
+        auto begin = std::chrono::steady_clock::now();
+        for (long i = 0; i < tasks_per_run; i += burst) {
+            if (bulk) {
+                for (int k = 0; k < burst; ++k) {
+                    batch.emplace_back([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+                }
+                pool.enqueue_bulk(std::span<inline_task>(batch));
+                batch.clear();
+            } else {
+                for (int k = 0; k < burst; ++k) {
+                    pool.enqueue([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+                }
+            }
+            // Keep a few bursts in flight so workers go idle between them, as with real accepts
+            while (done.load(std::memory_order_relaxed) < i - 3 * burst) {
+                std::this_thread::yield();
+            }
+        }
+        while (done.load(std::memory_order_relaxed) < tasks_per_run) {
+            std::this_thread::yield();
+        }
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    }
+    std::printf("burst %2d %-13s %6.0f ms %7.3f locks/task\n", burst, bulk ? "enqueue_bulk" : "enqueue", ms,
+                static_cast<double>(lock_calls.load() - locks_before) / tasks_per_run);
+}
+
+} // namespace
+
+int main() {
+    for (int burst : {1, 8, 64}) {
+        run(burst, false);
+        run(burst, true);
+    }
+    return 0;
+}
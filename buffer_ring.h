@@ -0,0 +1,119 @@
+#ifndef BUFFER_RING_H
+#define BUFFER_RING_H
+
+#ifdef HAVE_LIBURING
+
+#include <liburing.h>     // io_uring library
+#include <memory>
+#include <vector>
+#include <algorithm>    // For std::min
+#include <system_error>
+#include <stdexcept>
+
+// Provided buffer ring (IORING_REGISTER_PBUF_RING) shared by every recv on one ring.
+// The kernel picks a buffer only when data actually arrives, so idle connections
+// hold no memory. Buffers are added in chunks: the pool starts with one chunk and
+// grows whenever the kernel runs dry (-ENOBUFS), up to the ring capacity, so the
+// footprint follows the number of reads in flight, not the number of connections.
+// Returned buffers are staged and published with a single tail store per batch.
+class buffer_ring_pool {
+public:
+    buffer_ring_pool(struct io_uring* ring, int group_id, unsigned capacity,
+                     unsigned chunk_buffers, unsigned buffer_size)
+                : ring_(ring),
+                  group_id_(group_id),
+                  capacity_(round_up_pow2(capacity)),
+                  chunk_shift_(log2_pow2(round_up_pow2(std::min(chunk_buffers, capacity_)))),
+                  buffer_size_(buffer_size),
+                  mask_(io_uring_buf_ring_mask(capacity_)) {
+        if (capacity == 0 || chunk_buffers == 0 || buffer_size == 0) {
+            throw std::invalid_argument("Buffer ring needs a non-zero capacity, chunk and buffer size");
+        }
+        int ret = 0;
+        buf_ring_ = io_uring_setup_buf_ring(ring_, capacity_, group_id_, 0, &ret);
+        if (!buf_ring_) {
+            throw std::system_error(-ret, std::generic_category(), "io_uring_setup_buf_ring");
+        }
+        grow();
+    }
+    ~buffer_ring_pool() {
+        io_uring_free_buf_ring(ring_, buf_ring_, capacity_, group_id_);
+    }
+    buffer_ring_pool(const buffer_ring_pool&) = delete;
+    buffer_ring_pool& operator=(const buffer_ring_pool&) = delete;
+
+    int group_id() const { return group_id_; }
+    unsigned buffer_size() const { return buffer_size_; }
+    unsigned buffers() const { return buffers_; } // Buffers allocated so far
+
+    char* buffer(unsigned bid) const {
+        return chunks_[bid >> chunk_shift_].get() + static_cast<size_t>(bid & chunk_mask()) * buffer_size_;
+    }
+
+    // Hand a consumed buffer back; it becomes visible to the kernel on commit()
+    void recycle(unsigned bid) {
+        io_uring_buf_ring_add(buf_ring_, buffer(bid), buffer_size_, bid, mask_, staged_++);
+    }
+    void commit() {
+        if (staged_) {
+            io_uring_buf_ring_advance(buf_ring_, staged_);
+            staged_ = 0;
+        }
+    }
+
+    // Called after -ENOBUFS: publish staged buffers if there are any, otherwise
+    // allocate another chunk. Returns false once the ring is full.
+    bool replenish() {
+        if (staged_) {
+            commit();
+            return true;
+        }
+        return grow();
+    }
+
+private:
+    static unsigned round_up_pow2(unsigned n) {
+        unsigned p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+    static unsigned log2_pow2(unsigned n) {
+        unsigned shift = 0;
+        while ((1u << shift) < n) {
+            ++shift;
+        }
+        return shift;
+    }
+    unsigned chunk_mask() const { return (1u << chunk_shift_) - 1; }
+
+    bool grow() {
+        unsigned chunk = 1u << chunk_shift_;
+        if (buffers_ + chunk > capacity_) {
+            return false;
+        }
+        chunks_.emplace_back(new char[static_cast<size_t>(chunk) * buffer_size_]);
+        for (unsigned i = 0; i < chunk; ++i) {
+            recycle(buffers_ + i);
+        }
+        buffers_ += chunk;
+        commit();
+        return true;
+    }
+
+    struct io_uring* ring_;
+    int group_id_;
+    unsigned capacity_;     // Ring entries, upper bound on buffers (power of two)
+    unsigned chunk_shift_;  // log2 of buffers added per grow()
+    unsigned buffer_size_;  // Bytes per buffer
+    int mask_;
+    struct io_uring_buf_ring* buf_ring_ = nullptr;
+    std::vector<std::unique_ptr<char[]>> chunks_; // Stable backing memory, one block per chunk
+    unsigned buffers_ = 0;  // Buffers handed to the ring so far
+    unsigned staged_ = 0;   // Recycled buffers not yet published
+};
+
+#endif // HAVE_LIBURING
+
+#endif // BUFFER_RING_H
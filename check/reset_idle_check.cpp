@@ -0,0 +1,80 @@
+// Regression check: a client that resets an idle keep-alive connection must not
+// take the server down. Sends one request, reads the response, closes with
+// SO_LINGER {1, 0} (RST instead of FIN), then checks that new connections are
+// still served. Usage: reset_idle_check <port>; exits non-zero on failure.
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+constexpr char request[] = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+int connect_to(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct timeval timeout = {2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Sends one request and reads until the status line has arrived
+bool get_ok(int fd) {
+    if (write(fd, request, sizeof(request) - 1) != static_cast<ssize_t>(sizeof(request) - 1)) {
+        return false;
+    }
+    std::string reply;
+    char buffer[4096];
+    while (reply.find("\r\n") == std::string::npos) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            return false;
+        }
+        reply.append(buffer, n);
+    }
+    return reply.compare(0, 12, "HTTP/1.1 200") == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <port>\n", argv[0]);
+        return 2;
+    }
+    int port = std::atoi(argv[1]);
+    for (int round = 0; round < 3; ++round) {
+        int fd = connect_to(port);
+        if (fd < 0 || !get_ok(fd)) {
+            std::fprintf(stderr, "round %d: request before the reset failed: %s\n", round, strerror(errno));
+            return 1;
+        }
+        struct linger reset = {1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+        close(fd); // RST on an idle keep-alive connection
+        usleep(100 * 1000); // Let the server see the reset before the next connect
+    }
+    int fd = connect_to(port);
+    if (fd < 0 || !get_ok(fd)) {
+        std::fprintf(stderr, "server stopped serving after idle resets: %s\n", strerror(errno));
+        return 1;
+    }
+    close(fd);
+    std::printf("port %d: still serving after idle connection resets\n", port);
+    return 0;
+}
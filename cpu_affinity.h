@@ -0,0 +1,235 @@
+#ifndef CPU_AFFINITY_H
+#define CPU_AFFINITY_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>    // For std::sort
+#include <cstdlib>      // For std::getenv
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Where worker i of a pool runs. The CPU order is computed once from sysfs
+// topology, restricted to the CPUs this process may use:
+//   compact - fill one NUMA node (and one core's SMT siblings) before the next,
+//             so neighbouring workers share caches and memory
+//   scatter - one worker per node in turn, physical cores before SMT siblings,
+//             so workers get the most cache and memory bandwidth each
+//   list    - an explicit CPU list ("0,2,4-7"), worker i gets entry i mod size
+//   none    - leave placement to the scheduler
+// Pinning also makes first-touch allocation land on the worker's own node.
+class cpu_placement {
+public:
+    enum class policy { none, compact, scatter, list };
+
+    explicit cpu_placement(policy p = policy::none, std::vector<int> cpus = {})
+                : policy_(p), order_(p == policy::list ? std::move(cpus) : topology_order(p)) {
+        if (policy_ == policy::list && order_.empty()) {
+            throw std::invalid_argument("Explicit CPU placement needs at least one CPU");
+        }
+    }
+
+    // "none", "compact", "scatter" or a CPU list such as "0,2,4-7"
+    static cpu_placement parse(const std::string& spec) {
+        if (spec.empty() || spec == "none") {
+            return cpu_placement(policy::none);
+        }
+        if (spec == "compact") {
+            return cpu_placement(policy::compact);
+        }
+        if (spec == "scatter") {
+            return cpu_placement(policy::scatter);
+        }
+        try {
+            return cpu_placement(policy::list, parse_cpu_list(spec));
+        } catch (const std::logic_error&) { // std::stoi failures and bad ranges
+            throw std::invalid_argument("Unknown CPU placement: " + spec);
+        }
+    }
+
+    // Placement for pools that do not choose their own: the --cpu-placement
+    // override if one was given, then $CPU_PLACEMENT, then fallback
+    static cpu_placement configured(policy fallback = policy::none) {
+        if (!override_spec().empty()) {
+            return parse(override_spec());
+        }
+        if (const char* env = std::getenv("CPU_PLACEMENT"); env && *env) {
+            return parse(env);
+        }
+        return cpu_placement(fallback);
+    }
+    static void set_override(const std::string& spec) {
+        parse(spec); // Reject a bad spec up front
+        override_spec() = spec;
+    }
+
+    bool enabled() const { return policy_ != policy::none && !order_.empty(); }
+
+    // CPU for worker index, -1 when placement is disabled
+    int cpu_for(size_t index) const {
+        return enabled() ? order_[index % order_.size()] : -1;
+    }
+
+    bool pin_thread(std::thread& thread, size_t index) const {
+        return pin(thread.native_handle(), index);
+    }
+    bool pin_current_thread(size_t index) const {
+        return pin(pthread_self(), index);
+    }
+    // For forked workers: the whole (single-threaded) process
+    bool pin_current_process(size_t index) const {
+        int cpu = cpu_for(index);
+        if (cpu < 0) {
+            return false;
+        }
+        cpu_set_t set = single_cpu(cpu);
+        if (sched_setaffinity(0, sizeof(set), &set) < 0) {
+            std::cerr << "Failed to pin worker " << index << " to CPU " << cpu << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static std::string& override_spec() {
+        static std::string spec;
+        return spec;
+    }
+
+    static cpu_set_t single_cpu(int cpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return set;
+    }
+
+    bool pin(pthread_t thread, size_t index) const {
+        int cpu = cpu_for(index);
+        if (cpu < 0) {
+            return false;
+        }
+        cpu_set_t set = single_cpu(cpu);
+        int ret = pthread_setaffinity_np(thread, sizeof(set), &set);
+        if (ret != 0) {
+            std::cerr << "Failed to pin worker " << index << " to CPU " << cpu << ": " << strerror(ret) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    static std::vector<int> parse_cpu_list(const std::string& spec) {
+        std::vector<int> cpus;
+        std::stringstream ss(spec);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (item.empty()) {
+                continue;
+            }
+            size_t dash = item.find('-');
+            int first = std::stoi(item.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            if (first < 0 || last < first || last >= CPU_SETSIZE) {
+                throw std::invalid_argument("Bad CPU range: " + item);
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    static int read_sysfs_int(const std::string& path, int fallback) {
+        std::ifstream in(path);
+        int value;
+        return in >> value ? value : fallback;
+    }
+
+    // NUMA node of every CPU, 0 where sysfs has no node information
+    static std::vector<int> cpu_nodes() {
+        std::vector<int> nodes(CPU_SETSIZE, 0);
+        for (int node = 0; node < 1024; ++node) {
+            std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!in) {
+                if (node > 0) {
+                    break;
+                }
+                continue;
+            }
+            std::string list;
+            std::getline(in, list);
+            for (int cpu : parse_cpu_list(list)) {
+                nodes[cpu] = node;
+            }
+        }
+        return nodes;
+    }
+
+    static std::vector<int> topology_order(policy p) {
+        if (p == policy::none) {
+            return {};
+        }
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0) {
+            return {};
+        }
+        std::vector<int> nodes = cpu_nodes();
+        struct cpu_info {
+            int cpu, node, package, core, sibling; // sibling: rank among the core's SMT threads
+        };
+        std::vector<cpu_info> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (!CPU_ISSET(cpu, &allowed)) {
+                continue;
+            }
+            std::string topo = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            cpus.push_back({cpu, nodes[cpu], read_sysfs_int(topo + "physical_package_id", 0),
+                            read_sysfs_int(topo + "core_id", cpu), 0});
+        }
+        // Compact order first; scatter is derived from it
+        std::sort(cpus.begin(), cpus.end(), [](const cpu_info& a, const cpu_info& b) {
+            return std::tie(a.node, a.package, a.core, a.cpu) < std::tie(b.node, b.package, b.core, b.cpu);
+        });
+        for (size_t i = 1; i < cpus.size(); ++i) {
+            if (cpus[i].package == cpus[i - 1].package && cpus[i].core == cpus[i - 1].core) {
+                cpus[i].sibling = cpus[i - 1].sibling + 1;
+            }
+        }
+        if (p == policy::scatter) {
+            // Rank of each CPU's core within its node, then interleave the nodes
+            std::vector<std::tuple<int, int, int, int>> keyed; // (sibling, core rank, node, cpu)
+            int rank = 0;
+            for (size_t i = 0; i < cpus.size(); ++i) {
+                if (i > 0 && cpus[i].node != cpus[i - 1].node) {
+                    rank = 0;
+                } else if (i > 0 && cpus[i].sibling == 0) {
+                    ++rank;
+                }
+                keyed.emplace_back(cpus[i].sibling, rank, cpus[i].node, cpus[i].cpu);
+            }
+            std::sort(keyed.begin(), keyed.end());
+            std::vector<int> order;
+            for (const auto& k : keyed) {
+                order.push_back(std::get<3>(k));
+            }
+            return order;
+        }
+        std::vector<int> order;
+        for (const cpu_info& c : cpus) {
+            order.push_back(c.cpu);
+        }
+        return order;
+    }
+
+    policy policy_;
+    std::vector<int> order_; // CPU of worker i is order_[i % size]
+};
+
+#endif // CPU_AFFINITY_H
@@ -21,16 +21,21 @@
 #include <algorithm>    // For std::max
 #include <stdexcept>    // For std::runtime_error
 #include <span>
+#include <atomic>
+#include <thread>
+#include "mpsc_queue.h"
+#include "handler_table.h"
 
 
 class dispatcherepoll : public Eventloop {
 public:
-    explicit dispatcherepoll(int max_events = 1024) 
+    explicit dispatcherepoll(int max_events = 1024, size_t pending_capacity = 4096) 
                 : max_events_(max_events),
                   events(max_events),
                   loop_running(true),
                   epoll_fd_(create_epoll_fd()),
-                  wakeup_fd_(create_wakeup_fd()) {
+                  wakeup_fd_(create_wakeup_fd()),
+                  pending_operations_(pending_capacity) {
 
         register_wakeup_handler();
     }
@@ -41,14 +46,13 @@ public:
         pending_close_fds_.emplace_back(fd);
     }
     void register_handler(int fd, EventIOType event_type, std::shared_ptr<EventHandler> handler) override {
-        pending_operations_.emplace(PendingOperation::Type::REGISTER, fd, event_type, handler);
-        wakeup(); // Wake up the event loop to process pending operations
+        enqueue_operation(PendingOperation(PendingOperation::Type::REGISTER, fd, event_type, std::move(handler)));
     }
     void unregister_handler(int fd, EventIOType event_type) override {
-        pending_operations_.emplace(PendingOperation::Type::UNREGISTER, fd, event_type, nullptr);
-        wakeup(); // Wake up the event loop to process pending operations
+        enqueue_operation(PendingOperation(PendingOperation::Type::UNREGISTER, fd, event_type, nullptr));
     }
     void loop() override {
+        loop_thread_id_.store(std::this_thread::get_id(), std::memory_order_release);
         while (loop_running) {
 
             int num_events = epoll_wait(epoll_fd_.get(), events.data(), max_events_, -1);
@@ -63,6 +67,8 @@ public:
 
             // Process active events
             dispatch_active_events(num_events);
+            // Apply operations queued by handlers during this iteration
+            process_local_operations();
             // Process pending close file descriptors
             process_pending_close_fds();
         }
@@ -72,6 +78,20 @@ public:
         std::cout << "Stopping dispatcherepoll event loop." << std::endl;
     }
 private:
+    struct PendingOperation {
+        enum class Type { REGISTER, UNREGISTER };
+        int fd; // File descriptor
+        EventIOType event_type; // Event type
+        std::shared_ptr<EventHandler> handler; // Event handler
+        Type type; // Type of operation (register or unregister)
+        PendingOperation(Type type, int fd, EventIOType event_type, std::shared_ptr<EventHandler> handler)
+            : type(type), fd(fd), event_type(event_type), handler(std::move(handler)) {
+            if (fd < 0) {
+                throw std::invalid_argument("File descriptor cannot be negative");
+            }
+        }
+        PendingOperation() = default; // Default constructor for empty initialization
+    };
     static int create_epoll_fd() {
         int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
         if (epoll_fd < 0) {
@@ -91,7 +111,7 @@ private:
     void register_wakeup_handler() {
         struct epoll_event ev;
         ev.events = EPOLLIN | EPOLLET; // Edge-triggered read event
-        ev.data.ptr = this; // Store the pointer to the dispatcher itself
+        ev.data.u64 = wakeup_token; // Reserved token, never produced by handler_table
         if (epoll_ctl(epoll_fd_.get(), EPOLL_CTL_ADD, wakeup_fd_.get(), &ev) < 0) {
             perror("epoll_ctl MOD wakeup_fd");
             throw std::system_error(errno, std::generic_category(), "Failed to re-register wakeup handler");
@@ -103,6 +123,38 @@ private:
             perror("write to wakeup_fd");
         }
     }
+    bool in_loop_thread() const {
+        return loop_thread_id_.load(std::memory_order_acquire) == std::this_thread::get_id();
+    }
+    void enqueue_operation(PendingOperation&& op) {
+        if (in_loop_thread()) {
+            // Handlers run on the loop thread: no atomics and no eventfd write needed,
+            // the operation is applied right after the current dispatch round.
+            local_operations_.emplace_back(std::move(op));
+            return;
+        }
+        while (!pending_operations_.try_push(std::move(op))) {
+            std::this_thread::yield(); // Ring is full, wait for the loop thread to drain it
+        }
+        // Coalesce wakeups: only the producer that flips the flag writes the eventfd
+        if (!wakeup_pending_.exchange(true, std::memory_order_acq_rel)) {
+            wakeup();
+        }
+    }
+    void apply_operation(PendingOperation& op) {
+        if (op.type == PendingOperation::Type::REGISTER) {
+            do_register_handler(op.fd, op.event_type, op.handler);
+        } else if (op.type == PendingOperation::Type::UNREGISTER) {
+            do_unregister_handler(op.fd, op.event_type);
+        }
+    }
+    void process_local_operations() {
+        // Index loop: applying an operation never appends, but keep it robust anyway
+        for (size_t i = 0; i < local_operations_.size(); ++i) {
+            apply_operation(local_operations_[i]);
+        }
+        local_operations_.clear();
+    }
     void handle_wakeup() {
         uint64_t u;
         while (read(wakeup_fd_.get(), &u, sizeof(u)) == sizeof(u))
@@ -112,20 +164,11 @@ private:
             perror("read from wakeup_fd");
         }
 
-        //create a temp taskes to swap pending_operation
-        std::queue<PendingOperation> temp_queue;
-        {
-            std::lock_guard<std::mutex> lock(pending_op_mutex_);
-            std::swap(pending_operations_, temp_queue);
-        }
-        while (!temp_queue.empty()) {
-            PendingOperation op = std::move(temp_queue.front());
-            temp_queue.pop();
-            if (op.type == PendingOperation::Type::REGISTER) {
-                do_register_handler(op.fd, op.event_type, op.handler);
-            } else if (op.type == PendingOperation::Type::UNREGISTER) {
-                do_unregister_handler(op.fd, op.event_type);
-            }
+        // Clear the flag before draining so a push racing with the drain writes the eventfd again
+        wakeup_pending_.exchange(false, std::memory_order_acq_rel);
+        PendingOperation op;
+        while (pending_operations_.try_pop(op)) {
+            apply_operation(op);
         }
     }
     uint32_t convert_to_epoll_events(EventIOType type) {
@@ -146,6 +189,9 @@ private:
         if (has_event(type, EventIOType::HANGUP)) {
             epoll_events |= EPOLLHUP; // Hangup event
         }
+        if (has_event(type, EventIOType::EXCLUSIVE)) {
+            epoll_events |= EPOLLEXCLUSIVE; // Rejected by EPOLL_CTL_MOD, register such fds once
+        }
 
         return epoll_events;
     }
@@ -154,16 +200,12 @@ private:
         if (fd < 0 || !handler) {
             throw std::invalid_argument("Invalid file descriptor or handler");
         }
+        // If the fd already has a handler it is in the epoll set, modify it
+        int op = handlers_.find(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
         struct epoll_event ev;
         ev.events = convert_to_epoll_events(event_type);
-        ev.data.fd = fd;
-
-        int op = EPOLL_CTL_ADD;
-        if (active_handlers_by_fd_.find(fd) != active_handlers_by_fd_.end() &&
-            active_handlers_by_fd_[fd] == handler) {
-            // If the handler already exists, modify it
-            op = EPOLL_CTL_MOD;
-        }
+        ev.data.u64 = handlers_.insert(fd, std::move(handler)); // (generation, fd) token
 
         if (epoll_ctl(epoll_fd_.get(), op, fd, &ev) < 0) {
             if(op == EPOLL_CTL_ADD && errno == EEXIST) {
@@ -174,18 +216,17 @@ private:
                 }
             } else {
                 perror("epoll_ctl ADD");
+                handlers_.remove(fd);
                 throw std::system_error(errno, std::generic_category(), "Failed to register handler");
             }
         }
-        // Store the handler in the active handlers map
-        active_handlers_by_fd_[fd] = handler;
     }
 
     void do_unregister_handler(int fd, EventIOType event_type) {
         if (fd < 0) {
             throw std::invalid_argument("Invalid file descriptor");
         }
-        if (active_handlers_by_fd_.find(fd) == active_handlers_by_fd_.end()) {
+        if (!handlers_.find(fd)) {
             std::cerr << "No handler registered for fd: " << fd << std::endl;
             return; // No handler to unregister
         }
@@ -193,19 +234,19 @@ private:
             perror("epoll_ctl DEL");
             throw std::system_error(errno, std::generic_category(), "Failed to unregister handler");
         }
-        // Remove the handler from the active handlers map
-        auto it = active_handlers_by_fd_.find(fd);
-        if (it != active_handlers_by_fd_.end()) {
-            active_handlers_by_fd_.erase(it);
-        } else {
-            std::cerr << "No handler found for fd: " << fd << std::endl;
-        }
+        // Release the slot and bump its generation
+        handlers_.remove(fd);
         // Add the fd to the pending close list
         pending_close_fds_.emplace_back(fd);
     }
 
     void process_pending_close_fds() {
         for (int fd : pending_close_fds_) {
+            if (handlers_.find(fd)) {
+                // close_fd_safely without a prior unregister, drop the slot as the other backends do
+                epoll_ctl(epoll_fd_.get(), EPOLL_CTL_DEL, fd, nullptr);
+                handlers_.remove(fd);
+            }
             if (close(fd) < 0) {
                 perror("close");
             }
@@ -221,53 +262,39 @@ private:
         std::span<struct epoll_event> events_span(events.data(), num_events);
 
         for (const auto& event : events_span) {
-            if(event.data.ptr == this){
+            if(event.data.u64 == wakeup_token){
                 // Handle wakeup event
                 handle_wakeup();
                 continue; // Skip processing this event
-            }else{
-                auto it = active_handlers_by_fd_.find(event.data.fd);
-                if (it != active_handlers_by_fd_.end()) {
-                    EventHandler* handler = it->second.get();
-                    if (handler) {
-                        if (event.events & EPOLLIN) {
-                            handler->handle_read(event.data.fd);
-                        }
-                        if (event.events & EPOLLOUT) {
-                            handler->handle_write(event.data.fd);
-                        }
-                        if (event.events & (EPOLLERR | EPOLLHUP)) {
-                            handler->handle_exception(event.data.fd);
-                        }
-                    }
-                } else {
-                    std::cerr << "No handler found for fd: " << event.data.fd << std::endl;
-                }
+            }
+            // O(1) slot lookup, a stale event for a recycled fd fails the generation check
+            EventHandler* handler = handlers_.lookup(event.data.u64);
+            if (!handler) {
+                continue;
+            }
+            int fd = handler_table::token_fd(event.data.u64);
+            if (event.events & EPOLLIN) {
+                handler->handle_read(fd);
+            }
+            if (event.events & EPOLLOUT) {
+                handler->handle_write(fd);
+            }
+            if (event.events & (EPOLLERR | EPOLLHUP)) {
+                handler->handle_exception(fd);
             }
         }
     }
 
-    struct PendingOperation {
-        enum class Type { REGISTER, UNREGISTER };
-        int fd; // File descriptor
-        EventIOType event_type; // Event type
-        std::shared_ptr<EventHandler> handler; // Event handler
-        Type type; // Type of operation (register or unregister)
-        PendingOperation(Type type, int fd, EventIOType event_type, std::shared_ptr<EventHandler> handler)
-            : type(type), fd(fd), event_type(event_type), handler(std::move(handler)) {
-            if (fd < 0) {
-                throw std::invalid_argument("File descriptor cannot be negative");
-            }
-        }
-        PendingOperation() = default; // Default constructor for empty initialization
-    };
     FileDescriptor epoll_fd_;
     FileDescriptor wakeup_fd_;
     int max_events_; // Maximum number of events to handle at once
     std::vector<struct epoll_event> events; // Vector to hold events from epoll
-    std::queue<PendingOperation> pending_operations_;
-    std::mutex pending_op_mutex_;
-    std::unordered_map<int, std::shared_ptr<EventHandler>> active_handlers_by_fd_;
+    mpsc_ring<PendingOperation> pending_operations_; // Operations posted from other threads
+    std::vector<PendingOperation> local_operations_; // Operations posted from the loop thread itself
+    std::atomic<bool> wakeup_pending_{false}; // Set while an eventfd write is outstanding
+    std::atomic<std::thread::id> loop_thread_id_{}; // Thread currently running loop()
+    handler_table handlers_; // fd-indexed handler slots
+    static constexpr uint64_t wakeup_token = UINT64_MAX; // epoll data of the wakeup eventfd
 
     std::vector<int> pending_close_fds_; // Vector to hold file descriptors to be closed
     bool loop_running = true; // Flag to control the event loop
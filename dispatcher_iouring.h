@@ -0,0 +1,761 @@
+#ifndef IOURING_DISPATCHER_H
+#define IOURING_DISPATCHER_H
+
+#ifdef HAVE_LIBURING
+
+#include <signal.h>
+#include <iostream>
+#include <cstdlib>
+#include <errno.h>
+#include "event_dispatcher.h"
+#include <liburing.h>     // io_uring library
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <utility>      // For std::move
+#include <stdexcept>    // For std::runtime_error
+#include <system_error>
+#include <atomic>
+#include <thread>
+#include "mpsc_queue.h"
+#include "handler_table.h"
+#include "buffer_ring.h"
+#include "slot_allocator.h"
+
+// Completion-style callbacks for the io_uring native path. They run on the loop
+// thread; data handed to handle_recv is only valid for the duration of the call.
+class CompletionHandler {
+public:
+    virtual ~CompletionHandler() = default;
+    virtual void handle_accept(int client_fd) = 0; // New connection from the multishot accept
+    virtual void handle_recv(int fd, const char* data, int len) = 0; // len <= 0: peer closed or error
+    virtual void handle_send(int fd, int result) = 0; // Whole buffer sent (bytes) or -errno
+};
+
+// io_uring backend. It offers two faces:
+//  * the Eventloop readiness interface, emulated with POLL_ADD (multishot for EDGE_TRIGGERED,
+//    re-armed one-shot for level-triggered registrations) so any
+//    reactor-style server (and EventType::AUTO) can run on it;
+//  * a completion interface used by iouringserver: multishot accept, multishot
+//    recv into a shared provided buffer ring, and sends, all on registered (fixed)
+//    files. max_buffers bounds the reads in flight, not the connections.
+// Waiting for completions:
+//  * Native (default): submit and wait in one io_uring_submit_and_wait_timeout call;
+//    the cross-thread wakeup eventfd is itself watched by a multishot poll on the ring.
+//    With sqpoll a kernel thread consumes the SQ, so submitting costs no syscall at all.
+//  * EpollBridge: an eventfd registered with the ring signals completions. loop()
+//    epolls it, or another loop (e.g. a dispatcherepoll) can watch completion_fd()
+//    and call process_completions() to run both kinds of I/O on one thread.
+class dispatcheriouring : public Eventloop {
+public:
+    enum class WaitMode {
+        Native,
+        EpollBridge
+    };
+
+    explicit dispatcheriouring(unsigned queue_depth = 256,
+                               unsigned max_connections = 1024,
+                               unsigned max_buffers = 1024,
+                               unsigned buffer_size = 4096,
+                               size_t pending_capacity = 4096,
+                               WaitMode wait_mode = WaitMode::Native,
+                               bool sqpoll = false)
+                : max_connections_(max_connections),
+                  wait_mode_(wait_mode),
+                  event_fd_(wait_mode == WaitMode::EpollBridge ? create_eventfd() : -1),
+                  wakeup_fd_(create_eventfd()),
+                  epoll_fd_(wait_mode == WaitMode::EpollBridge ? create_epoll_fd() : -1),
+                  connections_(max_connections),
+                  pending_operations_(pending_capacity),
+                  file_slots_(max_connections) {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        if (sqpoll) {
+            params.flags |= IORING_SETUP_SQPOLL;
+            params.sq_thread_idle = sqpoll_idle_ms;
+        }
+        int ret = io_uring_queue_init_params(queue_depth, &ring_, &params);
+        if (ret < 0) {
+            throw std::system_error(-ret, std::generic_category(), "io_uring_queue_init_params");
+        }
+        try {
+            register_resources(max_buffers, buffer_size);
+            if (wait_mode_ == WaitMode::EpollBridge) {
+                setup_eventfd_and_epoll();
+            } else {
+                // Saves the fd table lookup on every io_uring_enter, failure only costs that
+                io_uring_register_ring_fd(&ring_);
+                arm_wakeup_poll();
+            }
+        } catch (...) {
+            buffers_.reset();
+            io_uring_queue_exit(&ring_);
+            throw;
+        }
+    }
+    ~dispatcheriouring() override {
+        std::cout << "dispatcheriouring destructor called." << std::endl;
+        buffers_.reset(); // Unregisters the buffer ring, must happen before the ring goes
+        io_uring_queue_exit(&ring_);
+    }
+
+    // --- Eventloop (readiness) interface ---
+    void close_fd_safely(int fd) override {
+        pending_close_fds_.emplace_back(fd);
+    }
+    void register_handler(int fd, EventIOType event_type, std::shared_ptr<EventHandler> handler) override {
+        enqueue_operation(PendingOperation(PendingOperation::Type::REGISTER, fd, event_type, std::move(handler)));
+    }
+    void unregister_handler(int fd, EventIOType event_type) override {
+        enqueue_operation(PendingOperation(PendingOperation::Type::UNREGISTER, fd, event_type, nullptr));
+    }
+    void loop() override {
+        loop_thread_id_.store(std::this_thread::get_id(), std::memory_order_release);
+        if (wait_mode_ == WaitMode::EpollBridge) {
+            epoll_bridge_loop();
+            return;
+        }
+        while (loop_running) {
+            // One syscall per batch: flush the SQ and block until a CQE is posted
+            struct io_uring_cqe* cqe = nullptr;
+            int ret = io_uring_submit_and_wait_timeout(&ring_, &cqe, 1, nullptr, nullptr);
+            if (ret < 0 && ret != -EINTR && ret != -ETIME) {
+                std::cerr << "io_uring_submit_and_wait_timeout error: " << strerror(-ret) << std::endl;
+                continue;
+            }
+
+            run_completions();
+        }
+    }
+    void stop() override {
+        loop_running = false;
+        std::cout << "Stopping dispatcheriouring event loop." << std::endl;
+    }
+
+    // --- Epoll bridge, EpollBridge mode only ---
+    // Readable whenever CQEs are posted; watch it from another loop and call
+    // process_completions() on the thread that owns this dispatcher.
+    int completion_fd() const {
+        return event_fd_.get();
+    }
+    void process_completions() {
+        loop_thread_id_.store(std::this_thread::get_id(), std::memory_order_release);
+        drain_eventfd(event_fd_.get());
+        run_completions();
+        io_uring_submit(&ring_); // Flush what the handlers queued
+    }
+
+    // --- Completion interface, loop thread only ---
+    void submit_accept(int listen_fd, CompletionHandler* handler) {
+        if (static_cast<size_t>(listen_fd) >= accept_handlers_.size()) {
+            accept_handlers_.resize(listen_fd + 1, nullptr);
+        }
+        accept_handlers_[listen_fd] = handler;
+        struct io_uring_sqe* sqe = get_sqe();
+        io_uring_prep_multishot_accept(sqe, listen_fd, nullptr, nullptr, 0);
+        io_uring_sqe_set_data64(sqe, make_user_data(RequestType::ACCEPT, 0, listen_fd));
+    }
+    // Registers fd in the fixed file table and arms a multishot recv on it
+    void open_connection(int fd, CompletionHandler* handler) {
+        int file_idx = file_slots_.allocate();
+        if (file_idx == -1) {
+            std::cerr << "Max connections reached, rejecting new client_fd: " << fd << std::endl;
+            close(fd);
+            return;
+        }
+        // The file slot doubles as the index of the connection's context in the slab
+        connection_state& conn = connections_[file_idx];
+        conn.handler = handler;
+        conn.fd = fd;
+        conn.generation = (conn.generation + 1) & generation_mask;
+        conn.recv_armed = false;
+        conn.open = true;
+        conn.installing = true;
+        if (static_cast<size_t>(fd) >= connection_of_fd_.size()) {
+            connection_of_fd_.resize(std::max<size_t>(fd + 1, connection_of_fd_.size() * 2), -1);
+        }
+        connection_of_fd_[fd] = file_idx;
+        // Install the socket in the fixed table from the SQ, linked so the recv only
+        // starts once the slot points at it. The kernel reads conn.fd when the update is
+        // issued, which may be after io_uring_enter returns (SQPOLL, punted work), so the
+        // slot is not handed out again before the update has completed.
+        struct io_uring_sqe* sqe = get_sqe();
+        io_uring_prep_files_update(sqe, &conn.fd, 1, file_idx);
+        sqe->flags |= IOSQE_IO_LINK;
+        io_uring_sqe_set_data64(sqe, make_user_data(RequestType::FILES_UPDATE, conn.generation, file_idx));
+        arm_recv(file_idx, conn);
+    }
+    // buf must stay valid until handle_send is called, short sends are resubmitted internally.
+    // Sends on one connection go out one at a time, in submission order.
+    void submit_send(int fd, const char* buf, size_t len) {
+        int idx = find_connection(fd);
+        if (idx < 0) {
+            return;
+        }
+        connection_state& conn = connections_[idx];
+        if (conn.sending) {
+            conn.queued_sends.emplace_back(buf, len); // Capacity is kept across connections
+            return;
+        }
+        conn.sending = true;
+        conn.send_buf = buf;
+        conn.send_len = len;
+        conn.sent = 0;
+        queue_send(idx, conn);
+    }
+    void close_connection(int fd) {
+        int idx = find_connection(fd);
+        if (idx < 0) {
+            return;
+        }
+        connection_state& conn = connections_[idx];
+        if (conn.recv_armed) {
+            struct io_uring_sqe* sqe = get_sqe();
+            io_uring_prep_cancel64(sqe, make_user_data(RequestType::RECV, conn.generation, idx), 0);
+            io_uring_sqe_set_data64(sqe, make_user_data(RequestType::NONE, 0, 0));
+            conn.recv_armed = false; // Its final -ECANCELED completion no longer matches
+        }
+        // Clear the fixed slot from the SQ as well: SQEs are issued in order, so queued
+        // sends and the cancel still see this socket, and a later open of the same
+        // slot is ordered after the clear. Nothing waits on a synchronous register.
+        struct io_uring_sqe* sqe = get_sqe();
+        io_uring_prep_files_update(sqe, &closed_file_, 1, idx);
+        io_uring_sqe_set_data64(sqe, make_user_data(RequestType::NONE, 0, 0));
+        conn.open = false;
+        conn.handler = nullptr;
+        conn.sending = false;
+        conn.queued_sends.clear();
+        connection_of_fd_[fd] = -1;
+        if (conn.installing) {
+            return; // The FILES_UPDATE completion closes fd and frees the slot
+        }
+        file_slots_.release(idx);
+        close(fd); // The fixed table keeps the socket alive until the clear is issued
+    }
+
+private:
+    static constexpr int buffer_group_id = 0;
+    static constexpr unsigned sqpoll_idle_ms = 1000; // SQPOLL thread sleeps after this much idle time
+    static constexpr unsigned buffer_chunk = 64; // Provided buffers added per pool growth step
+
+    // Request types carried in the top byte of the SQE user data
+    enum class RequestType : uint8_t {
+        NONE,   // Cancel/remove requests, their completions are ignored
+        WAKEUP, // Multishot poll on the cross-thread wakeup eventfd (Native mode)
+        POLL,   // Readiness notification for the Eventloop interface
+        ACCEPT, // Multishot accept
+        FILES_UPDATE, // Installs a new connection in the fixed file table
+        RECV,   // Multishot recv with buffer selection
+        SEND,   // Send from a caller-owned buffer
+    };
+
+    // No per-request allocation: user data is type(8) | generation(24) | index(32).
+    // index is the fd (POLL, ACCEPT) or the connection slot (RECV, SEND); the
+    // generation lets a completion that outlived its request be recognised as stale.
+    static constexpr uint32_t generation_mask = (1u << 24) - 1;
+    static uint64_t make_user_data(RequestType type, uint32_t generation, uint32_t index) {
+        return (static_cast<uint64_t>(type) << 56) |
+               (static_cast<uint64_t>(generation & generation_mask) << 32) | index;
+    }
+    static RequestType user_data_type(uint64_t data) {
+        return static_cast<RequestType>(data >> 56);
+    }
+    static uint32_t user_data_generation(uint64_t data) {
+        return static_cast<uint32_t>(data >> 32) & generation_mask;
+    }
+    static uint32_t user_data_index(uint64_t data) {
+        return static_cast<uint32_t>(data);
+    }
+
+    // Completion-mode connection, preallocated in a slab indexed by its fixed file slot
+    struct connection_state {
+        CompletionHandler* handler = nullptr;
+        int fd = -1;
+        uint32_t generation = 0;   // Bumped on every open, stale completions compare against it
+        bool recv_armed = false;   // A multishot recv is currently armed
+        bool open = false;
+        bool installing = false;   // FILES_UPDATE in flight, it still reads fd
+        bool sending = false;      // A send is in flight
+        const char* send_buf = nullptr; // In-flight send: caller-owned buffer
+        size_t send_len = 0;            // In-flight send: total length
+        size_t sent = 0;                // In-flight send: bytes already written
+        std::vector<std::pair<const char*, size_t>> queued_sends; // Waiting behind the in-flight send
+    };
+
+    struct poll_state {
+        uint64_t token = 0;     // handler_table token the poll was armed for
+        unsigned mask = 0;      // Poll events the handler asked for
+        bool edge = false;      // EDGE_TRIGGERED was requested, otherwise the poll is level-triggered
+        uint32_t sequence = 0;  // Bumped on every arm, identifies the current request
+        bool armed = false;     // A poll request is currently armed
+    };
+
+    struct PendingOperation {
+        enum class Type { REGISTER, UNREGISTER };
+        Type type; // Type of operation (register or unregister)
+        int fd; // File descriptor
+        EventIOType event_type; // Event type
+        std::shared_ptr<EventHandler> handler; // Event handler
+        PendingOperation(Type type, int fd, EventIOType event_type, std::shared_ptr<EventHandler> handler)
+            : type(type), fd(fd), event_type(event_type), handler(std::move(handler)) {
+            if (fd < 0) {
+                throw std::invalid_argument("File descriptor cannot be negative");
+            }
+        }
+        PendingOperation() = default; // Default constructor for empty initialization
+    };
+
+    static int create_eventfd() {
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd < 0) {
+            perror("eventfd");
+            throw std::system_error(errno, std::generic_category(), "Failed to create eventfd");
+        }
+        return fd;
+    }
+    static int create_epoll_fd() {
+        int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0) {
+            perror("epoll_create1");
+            throw std::system_error(errno, std::generic_category(), "Failed to create epoll instance");
+        }
+        return epoll_fd;
+    }
+    static void drain_eventfd(int fd) {
+        uint64_t u;
+        while (read(fd, &u, sizeof(u)) == sizeof(u))
+        {
+        }
+    }
+
+    void register_resources(unsigned max_buffers, unsigned buffer_size) {
+        // 1. Provided buffer ring: the kernel picks a buffer only when data arrives
+        buffers_ = std::make_unique<buffer_ring_pool>(&ring_, buffer_group_id, max_buffers,
+                                                      buffer_chunk, buffer_size);
+
+        // 2. Sparse fixed file table, slots are filled as connections are accepted
+        int ret = io_uring_register_files_sparse(&ring_, max_connections_);
+        if (ret < 0) {
+            throw std::system_error(-ret, std::generic_category(), "io_uring_register_files_sparse");
+        }
+    }
+    void setup_eventfd_and_epoll() {
+        int ret = io_uring_register_eventfd(&ring_, event_fd_.get());
+        if (ret < 0) {
+            throw std::system_error(-ret, std::generic_category(), "io_uring_register_eventfd");
+        }
+        for (int fd : {event_fd_.get(), wakeup_fd_.get()}) {
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            if (epoll_ctl(epoll_fd_.get(), EPOLL_CTL_ADD, fd, &ev) < 0) {
+                perror("epoll_ctl ADD eventfd");
+                throw std::system_error(errno, std::generic_category(), "Failed to add eventfd to epoll");
+            }
+        }
+    }
+
+    void epoll_bridge_loop() {
+        struct epoll_event events[2];
+        while (loop_running) {
+            io_uring_submit(&ring_); // Flush everything queued by the previous round
+
+            int num_events = epoll_wait(epoll_fd_.get(), events, 2, -1);
+            if (num_events < 0) {
+                if (errno == EINTR) {
+                    // Interrupted by a signal, continue the loop
+                    continue;
+                }
+                perror("epoll_wait error");
+                continue; // Handle error and continue the loop
+            }
+            for (int i = 0; i < num_events; ++i) {
+                if (events[i].data.fd == wakeup_fd_.get()) {
+                    handle_wakeup();
+                } else {
+                    drain_eventfd(event_fd_.get());
+                }
+            }
+
+            run_completions();
+        }
+    }
+    void run_completions() {
+        reap_completions();
+        // Apply operations queued by handlers during this iteration
+        process_local_operations();
+        // Process pending close file descriptors
+        process_pending_close_fds();
+    }
+    void arm_wakeup_poll() {
+        struct io_uring_sqe* sqe = get_sqe();
+        io_uring_prep_poll_multishot(sqe, wakeup_fd_.get(), POLLIN);
+        io_uring_sqe_set_data64(sqe, make_user_data(RequestType::WAKEUP, 0, 0));
+    }
+
+    struct io_uring_sqe* get_sqe() {
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+        if (!sqe) {
+            // Submission queue full: push what we have to the kernel and retry
+            io_uring_submit(&ring_);
+            sqe = io_uring_get_sqe(&ring_);
+            if (!sqe) {
+                throw std::runtime_error("No SQE available after submit");
+            }
+        }
+        return sqe;
+    }
+
+    // Connection slot of an open fd, -1 if fd is not a completion-mode connection
+    int find_connection(int fd) const {
+        if (fd < 0 || static_cast<size_t>(fd) >= connection_of_fd_.size()) {
+            return -1;
+        }
+        return connection_of_fd_[fd];
+    }
+    // A completion belongs to the current request if the slot was not closed or reused since
+    connection_state* current_connection(uint64_t data) {
+        connection_state& conn = connections_[user_data_index(data)];
+        return conn.open && conn.generation == user_data_generation(data) ? &conn : nullptr;
+    }
+    void arm_recv(int idx, connection_state& conn) {
+        struct io_uring_sqe* sqe = get_sqe();
+        io_uring_prep_recv_multishot(sqe, idx, nullptr, 0, 0);
+        sqe->flags |= IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+        sqe->buf_group = buffer_group_id;
+        io_uring_sqe_set_data64(sqe, make_user_data(RequestType::RECV, conn.generation, idx));
+        conn.recv_armed = true;
+    }
+    void queue_send(int idx, connection_state& conn) {
+        struct io_uring_sqe* sqe = get_sqe();
+        io_uring_prep_send(sqe, idx, conn.send_buf + conn.sent, conn.send_len - conn.sent, MSG_NOSIGNAL);
+        sqe->flags |= IOSQE_FIXED_FILE;
+        io_uring_sqe_set_data64(sqe, make_user_data(RequestType::SEND, conn.generation, idx));
+    }
+
+    // --- Readiness emulation ---
+    static unsigned convert_to_poll_events(EventIOType type) {
+        unsigned poll_events = 0;
+        if (has_event(type, EventIOType::READ)) {
+            poll_events |= POLLIN;
+        }
+        if (has_event(type, EventIOType::WRITE)) {
+            poll_events |= POLLOUT;
+        }
+        if (has_event(type, EventIOType::EXCEPTION)) {
+            poll_events |= POLLPRI; // POLLERR/POLLHUP are always reported
+        }
+        return poll_events;
+    }
+    poll_state& poll_slot(int fd) {
+        if (static_cast<size_t>(fd) >= polls_.size()) {
+            polls_.resize(std::max<size_t>(fd + 1, polls_.size() * 2));
+        }
+        return polls_[fd];
+    }
+    void arm_poll(int fd, poll_state& state, uint64_t token) {
+        state.token = token;
+        state.sequence = (state.sequence + 1) & generation_mask;
+        state.armed = true;
+        struct io_uring_sqe* sqe = get_sqe();
+        if (state.edge) {
+            io_uring_prep_poll_multishot(sqe, fd, state.mask);
+        } else {
+            // A multishot poll only fires on new readiness and the kernel refuses
+            // IORING_POLL_ADD_LEVEL on it. A one-shot poll checks the current state when
+            // armed, so re-arming it after the handler ran reports data still left
+            io_uring_prep_poll_add(sqe, fd, state.mask);
+        }
+        io_uring_sqe_set_data64(sqe, make_user_data(RequestType::POLL, state.sequence, fd));
+    }
+    void cancel_poll(int fd, poll_state& state) {
+        if (!state.armed) {
+            return;
+        }
+        struct io_uring_sqe* sqe = get_sqe();
+        io_uring_prep_poll_remove(sqe, make_user_data(RequestType::POLL, state.sequence, fd));
+        io_uring_sqe_set_data64(sqe, make_user_data(RequestType::NONE, 0, 0));
+        state.armed = false; // Its remaining completions no longer match
+    }
+    void do_register_handler(int fd, EventIOType event_type, std::shared_ptr<EventHandler> handler) {
+        if (fd < 0 || !handler) {
+            throw std::invalid_argument("Invalid file descriptor or handler");
+        }
+        uint64_t token = handlers_.insert(fd, std::move(handler));
+        poll_state& state = poll_slot(fd);
+        unsigned mask = state.mask | convert_to_poll_events(event_type);
+        bool edge = has_event(event_type, EventIOType::EDGE_TRIGGERED);
+        if (state.armed && state.mask == mask && state.edge == edge && state.token == token) {
+            return; // Same handler, same interest
+        }
+        cancel_poll(fd, state);
+        state.mask = mask;
+        state.edge = edge;
+        arm_poll(fd, state, token);
+    }
+    void do_unregister_handler(int fd, EventIOType event_type) {
+        handler_table::slot* slot = handlers_.find(fd);
+        if (!slot) {
+            return;
+        }
+        poll_state& state = poll_slot(fd);
+        cancel_poll(fd, state);
+        state.mask &= ~convert_to_poll_events(event_type);
+        if (state.mask) {
+            arm_poll(fd, state, handler_table::make_token(fd, slot->generation));
+        } else {
+            handlers_.remove(fd);
+        }
+    }
+
+    void process_pending_close_fds() {
+        for (int fd : pending_close_fds_) {
+            if (handlers_.find(fd)) {
+                poll_state& state = poll_slot(fd);
+                cancel_poll(fd, state);
+                state.mask = 0;
+                state.edge = false;
+                handlers_.remove(fd);
+            }
+            if (close(fd) < 0) {
+                perror("close");
+            }
+        }
+        pending_close_fds_.clear();
+    }
+
+    void wakeup() {
+        uint64_t u = 1;
+        if (write(wakeup_fd_.get(), &u, sizeof(u)) != sizeof(u)) {
+            perror("write to wakeup_fd");
+        }
+    }
+    bool in_loop_thread() const {
+        return loop_thread_id_.load(std::memory_order_acquire) == std::this_thread::get_id();
+    }
+    void enqueue_operation(PendingOperation&& op) {
+        if (in_loop_thread()) {
+            local_operations_.emplace_back(std::move(op));
+            return;
+        }
+        while (!pending_operations_.try_push(std::move(op))) {
+            std::this_thread::yield(); // Ring is full, wait for the loop thread to drain it
+        }
+        if (!wakeup_pending_.exchange(true, std::memory_order_acq_rel)) {
+            wakeup();
+        }
+    }
+    void apply_operation(PendingOperation& op) {
+        if (op.type == PendingOperation::Type::REGISTER) {
+            do_register_handler(op.fd, op.event_type, op.handler);
+        } else if (op.type == PendingOperation::Type::UNREGISTER) {
+            do_unregister_handler(op.fd, op.event_type);
+        }
+    }
+    void process_local_operations() {
+        for (size_t i = 0; i < local_operations_.size(); ++i) {
+            apply_operation(local_operations_[i]);
+        }
+        local_operations_.clear();
+    }
+    void handle_wakeup() {
+        drain_eventfd(wakeup_fd_.get());
+        wakeup_pending_.exchange(false, std::memory_order_acq_rel);
+        PendingOperation op;
+        while (pending_operations_.try_pop(op)) {
+            apply_operation(op);
+        }
+    }
+
+    // --- Completion processing ---
+    void reap_completions() {
+        struct io_uring_cqe* cqe;
+        unsigned head;
+        unsigned count = 0;
+        io_uring_for_each_cqe(&ring_, head, cqe) {
+            count++;
+            uint64_t data = io_uring_cqe_get_data64(cqe);
+            switch (user_data_type(data)) {
+                case RequestType::NONE:
+                    break; // Cancel/remove requests
+                case RequestType::WAKEUP:
+                    handle_wakeup();
+                    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                        arm_wakeup_poll();
+                    }
+                    break;
+                case RequestType::POLL:
+                    handle_poll_completion(cqe, data);
+                    break;
+                case RequestType::ACCEPT:
+                    handle_accept_completion(cqe, data);
+                    break;
+                case RequestType::FILES_UPDATE:
+                    handle_files_update_completion(cqe, data);
+                    break;
+                case RequestType::RECV:
+                    handle_recv_completion(cqe, data);
+                    break;
+                case RequestType::SEND:
+                    handle_send_completion(cqe, data);
+                    break;
+            }
+        }
+        io_uring_cq_advance(&ring_, count); // Mark all processed CQEs as consumed
+        buffers_->commit(); // Publish every buffer recycled in this batch with one tail update
+    }
+
+    void handle_poll_completion(struct io_uring_cqe* cqe, uint64_t data) {
+        int fd = static_cast<int>(user_data_index(data));
+        poll_state& state = polls_[fd];
+        if (!state.armed || state.sequence != user_data_generation(data)) {
+            return; // Completion of a cancelled or replaced poll
+        }
+        EventHandler* handler = cqe->res > 0 ? handlers_.lookup(state.token) : nullptr;
+        if (handler) {
+            unsigned revents = cqe->res;
+            if (revents & POLLIN) {
+                handler->handle_read(fd);
+            }
+            if (revents & POLLOUT) {
+                handler->handle_write(fd);
+            }
+            // A peer close with pending data is reported as POLLIN|POLLHUP, the read path handles it
+            if ((revents & (POLLERR | POLLHUP | POLLNVAL)) && !(revents & POLLIN)) {
+                handler->handle_exception(fd);
+            }
+        }
+        // One-shot polls end here, and the kernel may end a multishot poll on its own
+        // (e.g. CQ overflow); re-arm unless a handler cancelled or replaced it meanwhile
+        if (!(cqe->flags & IORING_CQE_F_MORE) && state.armed && state.sequence == user_data_generation(data)) {
+            state.armed = false;
+            if (cqe->res != -ECANCELED) {
+                arm_poll(fd, state, state.token);
+            }
+        }
+    }
+
+    void handle_accept_completion(struct io_uring_cqe* cqe, uint64_t data) {
+        int listen_fd = static_cast<int>(user_data_index(data));
+        CompletionHandler* handler = accept_handlers_[listen_fd];
+        if (cqe->res >= 0) {
+            handler->handle_accept(cqe->res);
+        } else if (cqe->res != -ECANCELED) {
+            std::cerr << "Accept failed: " << strerror(-cqe->res) << std::endl;
+        }
+        if (!(cqe->flags & IORING_CQE_F_MORE) && loop_running && cqe->res != -ECANCELED) {
+            submit_accept(listen_fd, handler); // Multishot accept terminated, re-arm
+        }
+    }
+
+    void handle_files_update_completion(struct io_uring_cqe* cqe, uint64_t data) {
+        int idx = static_cast<int>(user_data_index(data));
+        connection_state& slot = connections_[idx];
+        slot.installing = false;
+        if (!slot.open) {
+            // Closed while the update was in flight: only now is fd no longer read
+            file_slots_.release(idx);
+            close(slot.fd);
+            return;
+        }
+        if (cqe->res >= 0) {
+            return;
+        }
+        // The linked recv is cancelled with it, report the connection as failed
+        std::cerr << "Fixed file update failed for client_fd " << slot.fd << ": " << strerror(-cqe->res) << std::endl;
+        slot.recv_armed = false;
+        slot.handler->handle_recv(slot.fd, nullptr, cqe->res);
+    }
+
+    void handle_recv_completion(struct io_uring_cqe* cqe, uint64_t data) {
+        int res = cqe->res;
+        connection_state* conn = current_connection(data);
+        bool current = conn && conn->recv_armed;
+        bool has_buffer = cqe->flags & IORING_CQE_F_BUFFER;
+        unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+
+        if (current) {
+            if (res > 0 && has_buffer) {
+                conn->handler->handle_recv(conn->fd, buffers_->buffer(bid), res);
+            } else if (res != -ENOBUFS && res != -ECANCELED) {
+                conn->handler->handle_recv(conn->fd, nullptr, res); // EOF or error
+            }
+        }
+        if (has_buffer) {
+            buffers_->recycle(bid); // The handler is done with the bytes, give the buffer back
+        }
+        if (!(cqe->flags & IORING_CQE_F_MORE)) {
+            conn = current_connection(data); // The handler may have closed the connection
+            if (conn && conn->recv_armed) {
+                conn->recv_armed = false;
+                if (res == -ENOBUFS && !buffers_->replenish()) {
+                    // Every buffer is in flight and the ring is full, drop the connection
+                    std::cerr << "Out of provided buffers, closing client_fd: " << conn->fd << std::endl;
+                    conn->handler->handle_recv(conn->fd, nullptr, res);
+                } else if (res > 0 || res == -ENOBUFS) {
+                    arm_recv(user_data_index(data), *conn); // Multishot stopped but the connection is alive
+                }
+            }
+        }
+    }
+
+    void handle_send_completion(struct io_uring_cqe* cqe, uint64_t data) {
+        int res = cqe->res;
+        connection_state* conn = current_connection(data);
+        if (!conn || !conn->sending) {
+            return; // The connection was closed while the send was in flight
+        }
+        int idx = static_cast<int>(user_data_index(data));
+        if (res > 0 && conn->sent + res < conn->send_len) {
+            conn->sent += res;
+            queue_send(idx, *conn); // Short send, queue the rest
+            return;
+        }
+        int result = res < 0 ? res : static_cast<int>(conn->sent + res);
+        if (conn->queued_sends.empty()) {
+            conn->sending = false;
+        } else {
+            // Start the next send before the callback, which may close the connection
+            conn->send_buf = conn->queued_sends.front().first;
+            conn->send_len = conn->queued_sends.front().second;
+            conn->sent = 0;
+            conn->queued_sends.erase(conn->queued_sends.begin());
+            queue_send(idx, *conn);
+        }
+        conn->handler->handle_send(conn->fd, result);
+    }
+
+    struct io_uring ring_;
+    unsigned max_connections_;  // Size of the fixed file table
+    WaitMode wait_mode_;
+    std::unique_ptr<buffer_ring_pool> buffers_; // Provided buffers shared by all recvs
+
+    FileDescriptor event_fd_;   // EpollBridge: registered with the ring, readable when CQEs are posted
+    FileDescriptor wakeup_fd_;  // Cross-thread wakeup for pending operations
+    FileDescriptor epoll_fd_;   // EpollBridge: waits on event_fd_ and wakeup_fd_
+
+    handler_table handlers_; // fd-indexed readiness handlers
+    std::vector<poll_state> polls_; // fd-indexed multishot poll state
+    std::vector<connection_state> connections_; // Connection slab, indexed by fixed file slot
+    std::vector<int> connection_of_fd_; // fd -> connection slot, -1 if none
+    std::vector<CompletionHandler*> accept_handlers_; // Listening fd -> multishot accept owner
+    int closed_file_ = -1; // Source value for clearing a fixed file slot
+    mpsc_ring<PendingOperation> pending_operations_; // Operations posted from other threads
+    std::vector<PendingOperation> local_operations_; // Operations posted from the loop thread itself
+    std::atomic<bool> wakeup_pending_{false}; // Set while an eventfd write is outstanding
+    std::atomic<std::thread::id> loop_thread_id_{}; // Thread currently running loop()
+
+    slot_allocator file_slots_; // Free fixed file slots, O(1) allocate/release
+    std::vector<int> pending_close_fds_; // Vector to hold file descriptors to be closed
+    bool loop_running = true; // Flag to control the event loop
+};
+
+#endif // HAVE_LIBURING
+
+#endif // IOURING_DISPATCHER_H
@@ -0,0 +1,264 @@
+#ifndef POLL_DISPATCHER_H
+#define POLL_DISPATCHER_H
+
+#include <signal.h>
+#include <iostream>
+#include <cstdlib>
+#include <errno.h>
+#include "event_dispatcher.h"
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <utility>      // For std::move
+#include <stdexcept>    // For std::runtime_error
+#include <system_error>
+#include <atomic>
+#include <thread>
+#include "mpsc_queue.h"
+#include "handler_table.h"
+
+// poll() backend: one contiguous pollfd array handed to the kernel as is.
+// index_of_fd_ maps an fd to its position so removal is a swap with the last
+// entry, no FD_SETSIZE cap and no rescans over the whole descriptor range.
+class dispatcherpoll : public Eventloop {
+public:
+    explicit dispatcherpoll(size_t pending_capacity = 4096)
+                : wakeup_fd_(create_wakeup_fd()),
+                  pending_operations_(pending_capacity) {
+        // Entry 0 is always the wakeup eventfd
+        pollfds_.push_back({wakeup_fd_.get(), POLLIN, 0});
+    }
+    ~dispatcherpoll() {
+        std::cout << "dispatcherpoll destructor called." << std::endl;
+    }
+    void close_fd_safely(int fd) override {
+        pending_close_fds_.emplace_back(fd);
+    }
+    void register_handler(int fd, EventIOType event_type, std::shared_ptr<EventHandler> handler) override {
+        enqueue_operation(PendingOperation(PendingOperation::Type::REGISTER, fd, event_type, std::move(handler)));
+    }
+    void unregister_handler(int fd, EventIOType event_type) override {
+        enqueue_operation(PendingOperation(PendingOperation::Type::UNREGISTER, fd, event_type, nullptr));
+    }
+    void loop() override {
+        loop_thread_id_.store(std::this_thread::get_id(), std::memory_order_release);
+        while (loop_running) {
+            int num_events = poll(pollfds_.data(), pollfds_.size(), -1);
+            if (num_events < 0) {
+                if (errno == EINTR) {
+                    // Interrupted by a signal, continue the loop
+                    continue;
+                }
+                perror("poll error");
+                continue; // Handle error and continue the loop
+            }
+
+            // Process active events
+            dispatch_active_events(num_events);
+            // Apply operations queued by handlers during this iteration
+            process_local_operations();
+            // Process pending close file descriptors
+            process_pending_close_fds();
+        }
+    }
+    void stop() override {
+        loop_running = false;
+        std::cout << "Stopping dispatcherpoll event loop." << std::endl;
+    }
+private:
+    struct PendingOperation {
+        enum class Type { REGISTER, UNREGISTER };
+        Type type; // Type of operation (register or unregister)
+        int fd; // File descriptor
+        EventIOType event_type; // Event type
+        std::shared_ptr<EventHandler> handler; // Event handler
+        PendingOperation(Type type, int fd, EventIOType event_type, std::shared_ptr<EventHandler> handler)
+            : type(type), fd(fd), event_type(event_type), handler(std::move(handler)) {
+            if (fd < 0) {
+                throw std::invalid_argument("File descriptor cannot be negative");
+            }
+        }
+        PendingOperation() = default; // Default constructor for empty initialization
+    };
+
+    static int create_wakeup_fd() {
+        int wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeup_fd < 0) {
+            perror("eventfd");
+            throw std::system_error(errno, std::generic_category(), "Failed to create eventfd");
+        }
+        return wakeup_fd;
+    }
+    void wakeup() {
+        uint64_t u = 1;
+        if (write(wakeup_fd_.get(), &u, sizeof(u)) != sizeof(u)) {
+            perror("write to wakeup_fd");
+        }
+    }
+    bool in_loop_thread() const {
+        return loop_thread_id_.load(std::memory_order_acquire) == std::this_thread::get_id();
+    }
+    void enqueue_operation(PendingOperation&& op) {
+        if (in_loop_thread()) {
+            local_operations_.emplace_back(std::move(op));
+            return;
+        }
+        while (!pending_operations_.try_push(std::move(op))) {
+            std::this_thread::yield(); // Ring is full, wait for the loop thread to drain it
+        }
+        if (!wakeup_pending_.exchange(true, std::memory_order_acq_rel)) {
+            wakeup();
+        }
+    }
+    void apply_operation(PendingOperation& op) {
+        if (op.type == PendingOperation::Type::REGISTER) {
+            do_register_handler(op.fd, op.event_type, op.handler);
+        } else if (op.type == PendingOperation::Type::UNREGISTER) {
+            do_unregister_handler(op.fd, op.event_type);
+        }
+    }
+    void process_local_operations() {
+        for (size_t i = 0; i < local_operations_.size(); ++i) {
+            apply_operation(local_operations_[i]);
+        }
+        local_operations_.clear();
+    }
+    void handle_wakeup() {
+        uint64_t u;
+        while (read(wakeup_fd_.get(), &u, sizeof(u)) == sizeof(u))
+        {
+        }
+        wakeup_pending_.exchange(false, std::memory_order_acq_rel);
+        // Queued behind the local ones rather than applied here: this runs in the middle
+        // of dispatch_active_events, and a swap-remove or append would shift pollfds_
+        PendingOperation op;
+        while (pending_operations_.try_pop(op)) {
+            local_operations_.emplace_back(std::move(op));
+        }
+    }
+    static short convert_to_poll_events(EventIOType type) {
+        short poll_events = 0;
+
+        if (has_event(type, EventIOType::READ)) {
+            poll_events |= POLLIN;
+        }
+        if (has_event(type, EventIOType::WRITE)) {
+            poll_events |= POLLOUT;
+        }
+        if (has_event(type, EventIOType::EXCEPTION)) {
+            poll_events |= POLLPRI; // POLLERR/POLLHUP are always reported
+        }
+        return poll_events;
+    }
+
+    int index_of(int fd) const {
+        if (static_cast<size_t>(fd) >= index_of_fd_.size()) {
+            return -1;
+        }
+        return index_of_fd_[fd];
+    }
+
+    void do_register_handler(int fd, EventIOType event_type, std::shared_ptr<EventHandler> handler) {
+        if (fd < 0 || !handler) {
+            throw std::invalid_argument("Invalid file descriptor or handler");
+        }
+        handlers_.insert(fd, std::move(handler));
+
+        int index = index_of(fd);
+        if (index >= 0) {
+            // Already polled, add the new interest bits
+            pollfds_[index].events |= convert_to_poll_events(event_type);
+            return;
+        }
+        if (static_cast<size_t>(fd) >= index_of_fd_.size()) {
+            index_of_fd_.resize(std::max<size_t>(fd + 1, index_of_fd_.size() * 2), -1);
+        }
+        index_of_fd_[fd] = static_cast<int>(pollfds_.size());
+        pollfds_.push_back({fd, convert_to_poll_events(event_type), 0});
+    }
+
+    void do_unregister_handler(int fd, EventIOType event_type) {
+        int index = index_of(fd);
+        if (index <= 0) {
+            return; // Not polled (index 0 is the wakeup fd)
+        }
+        pollfds_[index].events &= ~convert_to_poll_events(event_type);
+        if (pollfds_[index].events == 0) {
+            remove_fd(fd);
+        }
+    }
+
+    // Swap-remove: the last entry takes the hole, O(1) with no compaction pass
+    void remove_fd(int fd) {
+        int index = index_of(fd);
+        if (index <= 0) {
+            return;
+        }
+        const struct pollfd& last = pollfds_.back();
+        index_of_fd_[last.fd] = index;
+        pollfds_[index] = last;
+        pollfds_.pop_back();
+        index_of_fd_[fd] = -1;
+        handlers_.remove(fd);
+    }
+
+    void process_pending_close_fds() {
+        for (int fd : pending_close_fds_) {
+            remove_fd(fd);
+            if (close(fd) < 0) {
+                perror("close");
+            }
+        }
+        pending_close_fds_.clear();
+    }
+
+    void dispatch_active_events(int num_events) {
+        // Every register/unregister, local or from another thread, is applied by
+        // process_local_operations() after this walk, so pollfds_ does not change here
+        for (size_t i = 0; i < pollfds_.size() && num_events > 0; ++i) {
+            short revents = pollfds_[i].revents;
+            if (revents == 0) {
+                continue;
+            }
+            --num_events;
+            int fd = pollfds_[i].fd;
+            if (i == 0) {
+                handle_wakeup();
+                continue;
+            }
+            handler_table::slot* slot = handlers_.find(fd);
+            if (!slot) {
+                continue;
+            }
+            EventHandler* handler = slot->handler;
+            if (revents & POLLIN) {
+                handler->handle_read(fd);
+            }
+            if (revents & POLLOUT) {
+                handler->handle_write(fd);
+            }
+            // A peer close with pending data is reported as POLLIN|POLLHUP, the read path handles it
+            if ((revents & (POLLERR | POLLHUP | POLLNVAL)) && !(revents & POLLIN)) {
+                handler->handle_exception(fd);
+            }
+        }
+    }
+
+    FileDescriptor wakeup_fd_;
+    std::vector<struct pollfd> pollfds_; // Contiguous array passed to poll()
+    std::vector<int> index_of_fd_; // fd -> position in pollfds_, -1 if not polled
+    handler_table handlers_; // fd-indexed handler slots
+    mpsc_ring<PendingOperation> pending_operations_; // Operations posted from other threads
+    std::vector<PendingOperation> local_operations_; // Operations posted from the loop thread itself
+    std::atomic<bool> wakeup_pending_{false}; // Set while an eventfd write is outstanding
+    std::atomic<std::thread::id> loop_thread_id_{}; // Thread currently running loop()
+
+    std::vector<int> pending_close_fds_; // Vector to hold file descriptors to be closed
+    bool loop_running = true; // Flag to control the event loop
+};
+
+#endif // POLL_DISPATCHER_H
@@ -19,10 +19,11 @@
 #include <utility>      // For std::move
 #include <algorithm>    // For std::max
 #include <stdexcept>    // For std::runtime_error
+#include <array>
 
 class dispatcherselect : public Eventloop {
 public:
-    dispatcherselect() {
+    dispatcherselect() : handlers_(FD_SETSIZE) {
         FD_ZERO(&read_fds);
         FD_ZERO(&write_fds);
         FD_ZERO(&except_fds);
@@ -37,7 +38,12 @@ public:
         pending_close_fds_.emplace_back(fd);
     }
 
+    // Throws std::invalid_argument for a descriptor select() cannot watch; the fd
+    // is left open, closing it is up to the caller that owns it
     void register_handler(int fd, EventIOType event_type, std::shared_ptr<EventHandler> handler) override {
+        if (fd < 0 || fd >= FD_SETSIZE) {
+            throw std::invalid_argument("fd " + std::to_string(fd) + " is outside select()'s FD_SETSIZE range");
+        }
         pending_operations_.emplace(PendingOperation::Type::REGISTER, fd, event_type, handler);
     }
 
@@ -99,7 +105,7 @@ private:
 
     void process_pending_close_fds() {
         for (int fd : pending_close_fds_) {
-            if(handlers_.count(fd) == 0) {
+            if(!has_handlers(fd)) {
                 std::cerr << "No handler registered for fd: " << fd << std::endl;
                 continue; // No handler registered, skip closing
             }
@@ -111,16 +117,35 @@ private:
         pending_close_fds_.clear();
     }
 
+    // Slot inside a per-fd handler entry for a single event type, -1 if unsupported
+    static int slot_of(EventIOType event_type) {
+        switch (event_type) {
+            case EventIOType::READ: return 0;
+            case EventIOType::WRITE: return 1;
+            case EventIOType::EXCEPTION: return 2;
+            default: return -1;
+        }
+    }
+
+    bool has_handlers(int fd) const {
+        if (fd < 0 || fd >= FD_SETSIZE) return false;
+        const auto& entry = handlers_[fd];
+        return entry[0] || entry[1] || entry[2];
+    }
+
     void do_register_handler(int fd, EventIOType event_type, std::shared_ptr<EventHandler> handler) {
+        if (fd < 0 || fd >= FD_SETSIZE) {
+            return; // Rejected by register_handler already
+        }
+        int slot = slot_of(event_type);
+        if (slot < 0) return;
+        handlers_[fd][slot] = std::move(handler);
         if (event_type == EventIOType::READ) {
             FD_SET(fd, &read_fds);
-            handlers_[fd][event_type] = handler;
         } else if (event_type == EventIOType::WRITE) {
             FD_SET(fd, &write_fds);
-            handlers_[fd][event_type] = handler;
         } else if (event_type == EventIOType::EXCEPTION) {
             FD_SET(fd, &except_fds);
-            handlers_[fd][event_type] = handler;
         }
         // Update max_fd if necessary
         if (fd > max_fd) {
@@ -129,32 +154,26 @@ private:
     }
 
     void do_unregister_handler(int fd, EventIOType event_type) {
-        if (handlers_.find(fd) == handlers_.end()) return;
+        int slot = slot_of(event_type);
+        if (!has_handlers(fd) || slot < 0) return;
 
-        handlers_[fd].erase(event_type);
+        handlers_[fd][slot].reset();
 
         if (event_type == EventIOType::READ) FD_CLR(fd, &read_fds);
         else if (event_type == EventIOType::WRITE) FD_CLR(fd, &write_fds);
         else if (event_type == EventIOType::EXCEPTION) FD_CLR(fd, &except_fds);
 
-        if (handlers_[fd].empty()) {
-            handlers_.erase(fd);
-        }
-
-        // Recalculate max_fd if necessary
+        // Recalculate max_fd if necessary, walking down from the old maximum
         if (fd == max_fd) {
-            max_fd = 0;
-            for (int i = 0; i < FD_SETSIZE; ++i) {
-                if (FD_ISSET(i, &read_fds) || FD_ISSET(i, &write_fds) || FD_ISSET(i, &except_fds)) {
-                    max_fd = std::max(max_fd, i);
-                }
+            while (max_fd >= 0 && !has_handlers(max_fd)) {
+                --max_fd;
             }
         }
     }
 
     void collect_active_events() {
         active_events.clear();
-        for (const auto& [fd, handler_map] : handlers_) {
+        for (int fd = 0; fd <= max_fd; ++fd) {
             if (FD_ISSET(fd, &read_fds_copy)) {
                 active_events.emplace_back(fd, EventIOType::READ);
             }
@@ -173,18 +192,17 @@ private:
         }
 
         for (const auto& [fd, event_type] : active_events) {
-            auto it = handlers_.find(fd);
-            if (it != handlers_.end()) {
-                auto handler_it = it->second.find(event_type);
-                if (handler_it != it->second.end()) {
-                    if (event_type == EventIOType::READ) {
-                        handler_it->second->handle_read(fd);
-                    } else if (event_type == EventIOType::WRITE) {
-                        handler_it->second->handle_write(fd);
-                    } else if (event_type == EventIOType::EXCEPTION) {
-                        handler_it->second->handle_exception(fd);
-                    }
-                }
+            // Direct index, the borrowed pointer avoids shared_ptr refcount traffic
+            EventHandler* handler = handlers_[fd][slot_of(event_type)].get();
+            if (!handler) {
+                continue;
+            }
+            if (event_type == EventIOType::READ) {
+                handler->handle_read(fd);
+            } else if (event_type == EventIOType::WRITE) {
+                handler->handle_write(fd);
+            } else if (event_type == EventIOType::EXCEPTION) {
+                handler->handle_exception(fd);
             }
         }
     }
@@ -206,7 +224,8 @@ private:
     std::vector<std::pair<int, EventIOType>> active_events;
     //pending queue for active events
     std::queue<PendingOperation> pending_operations_;
-    std::map<int, std::map<EventIOType, std::shared_ptr<EventHandler>>> handlers_;
+    // fd-indexed table of read/write/exception handlers, FD_SETSIZE entries
+    std::vector<std::array<std::shared_ptr<EventHandler>, 3>> handlers_;
 
     bool loop_running = true; // Flag to control the event loop
     fd_set read_fds;   // Set of file descriptors to monitor for read events
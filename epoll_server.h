@@ -1,14 +1,22 @@
+#ifndef EPOLL_SERVER_H
+#define EPOLL_SERVER_H
 #include "dispatcher_epoll.h"
 #include "socket.h"
 #include "event_dispatcher.h"
 #include <stdexcept>
 #include <unistd.h>
 #include <cstring>
-#include <unordered_map> 
+#include <cstdint>      // For SIZE_MAX
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include "ring_buffer.h"
+#include "output_queue.h"
 
 class epoll_event_handler : public Socket {
 public:
-    epoll_event_handler(int port = 8000) : Socket(port) {
+    epoll_event_handler(int port = 8000, bool reuse_port = false) : Socket(port, reuse_port) {
         epoll_event_loop = EventLoopFactory::create_event_loop(EventType::Epoll);
         if (!epoll_event_loop) {
             throw std::runtime_error("Failed to create event loop");
@@ -20,12 +28,12 @@ public:
             epoll_event_loop->stop(); // Stop the event loop
         }
         
-        for (const auto& pair : client_recv_buffers) {
-            if(epoll_event_loop) {
-                epoll_event_loop->unregister_handler(pair.first, EventIOType::READ);
+        for (size_t fd = 0; fd < connections.size(); ++fd) {
+            if (connections[fd] && epoll_event_loop) {
+                epoll_event_loop->unregister_handler(static_cast<int>(fd), EventIOType::READ);
             }
         }
-        client_recv_buffers.clear();
+        connections.clear();
 
         if(sockfd >= 0 && epoll_event_loop) {
             epoll_event_loop->unregister_handler(sockfd, EventIOType::READ);
@@ -43,81 +51,247 @@ public:
                                             std::make_shared<client_event_handler>(
                                                 epoll_event_loop.get(), 
                                                 [this](int fd) {
-                                                    while (true) {
-                                                        int client_fd = accept(fd, nullptr, nullptr);
-                                                        if (client_fd < 0) {
-                                                            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                                                                break;
-                                                            }
-                                                            perror("accept error");
-                                                            return;
-                                                        }
-                                                        set_non_blocking(client_fd); 
-
-                                                        epoll_event_loop->register_handler(client_fd, 
-                                                                                        EventIOType::READ | EventIOType::EDGE_TRIGGERED, 
-                                                                                        std::make_shared<client_event_handler>(
-                                                                                            epoll_event_loop.get(), 
-                                                                                            [this](int client_fd_to_handle) {
-                                                                                                clientconnections(client_fd_to_handle);
-                                                                                            }));
-                                                        client_recv_buffers[client_fd] = "";
-                                                    }
+                                                    accept_connections(fd, SIZE_MAX); // Edge-triggered: drain the queue
                                                 }
                                             )
                                         );
         epoll_event_loop->loop(); // Start the event loop
     }
+
+    // Runs the loop on a non-blocking listener created by someone else and shared with
+    // other reactors, e.g. inherited across fork(). With EPOLLEXCLUSIVE a connection
+    // wakes one waiting reactor instead of all of them. The listener stays
+    // level-triggered, so a backlog left after max_accept_burst is picked up on the
+    // next round and one reactor cannot swallow a whole burst.
+    void serve_shared(int listen_fd) {
+        sockfd = listen_fd;
+        epoll_event_loop->register_handler(sockfd,
+                                           EventIOType::READ | EventIOType::EXCLUSIVE,
+                                           std::make_shared<client_event_handler>(
+                                               epoll_event_loop.get(),
+                                               [this](int fd) {
+                                                   accept_connections(fd, max_accept_burst);
+                                               }));
+        epoll_event_loop->loop(); // Start the event loop
+    }
 private:
+    // Per-connection state. The receive ring is read into directly and never grows;
+    // objects are recycled through idle_connections so accepting allocates nothing.
+    // Responses wait in out until the socket takes them; EPOLLOUT is only armed while
+    // something is queued, and reading pauses while more than high_watermark is.
+    struct client_connection {
+        ring_buffer recv_buffer{recv_buffer_size};
+        http_parser parser;
+        output_queue out;
+        std::shared_ptr<EventHandler> handler; // Reused on re-registration so the token stays valid
+        bool write_armed = false;       // Registered for EPOLLOUT
+        bool reading_paused = false;    // Backpressure: input left unread until out drains
+        bool close_after_flush = false; // Close once out is empty
+    };
+    static constexpr size_t recv_buffer_size = 16384; // Largest request a connection can hold
+    static constexpr size_t max_idle_connections = 1024;
+    static constexpr size_t high_watermark = 65536; // Queued bytes that stop reading
+    static constexpr size_t low_watermark = 16384;  // Queued bytes below which reading resumes
+    static constexpr size_t max_accept_burst = 16;  // Accepts per wakeup on a shared listener
+
     std::unique_ptr<Eventloop> epoll_event_loop; 
-    std::unordered_map<int, std::string> client_recv_buffers; 
+    std::vector<std::unique_ptr<client_connection>> connections; // fd-indexed, null if not open
+    std::vector<std::unique_ptr<client_connection>> idle_connections; // Recycled connection objects
+
+    // Accepts up to limit connections from the non-blocking listener fd
+    void accept_connections(int fd, size_t limit) {
+        for (size_t accepted = 0; accepted < limit; ++accepted) {
+            int client_fd = accept(fd, nullptr, nullptr);
+            if (client_fd < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    perror("accept error");
+                }
+                return;
+            }
+            set_non_blocking(client_fd); 
+            open_connection(client_fd);
+
+            epoll_event_loop->register_handler(client_fd, 
+                                            EventIOType::READ | EventIOType::EDGE_TRIGGERED, 
+                                            connections[client_fd]->handler);
+        }
+    }
+
+    void open_connection(int client_fd) {
+        if (static_cast<size_t>(client_fd) >= connections.size()) {
+            connections.resize(std::max<size_t>(client_fd + 1, connections.size() * 2));
+        }
+        if (idle_connections.empty()) {
+            auto conn = std::make_unique<client_connection>();
+            conn->handler = std::make_shared<client_event_handler>(
+                                    epoll_event_loop.get(),
+                                    [this](int client_fd_to_handle) {
+                                        clientconnections(client_fd_to_handle);
+                                    },
+                                    [this](int client_fd_to_handle) {
+                                        on_writable(client_fd_to_handle);
+                                    },
+                                    [this](int client_fd_to_handle) {
+                                        on_error(client_fd_to_handle);
+                                    });
+            connections[client_fd] = std::move(conn);
+            return;
+        }
+        connections[client_fd] = std::move(idle_connections.back());
+        idle_connections.pop_back();
+        client_connection& conn = *connections[client_fd];
+        conn.recv_buffer.clear();
+        conn.parser.reset();
+        conn.out.clear();
+        conn.write_armed = false;
+        conn.reading_paused = false;
+        conn.close_after_flush = false;
+    }
+
+    void close_client(int client_fd) {
+        epoll_event_loop->unregister_handler(client_fd, EventIOType::READ);
+        if (idle_connections.size() < max_idle_connections) {
+            idle_connections.push_back(std::move(connections[client_fd]));
+        }
+        connections[client_fd].reset();
+    }
+
+    client_connection* find_connection(int client_fd) {
+        if (static_cast<size_t>(client_fd) >= connections.size()) {
+            return nullptr;
+        }
+        return connections[client_fd].get();
+    }
+
+    // Answers every complete request in the receive ring; false on a malformed one
+    bool parse_requests(client_connection& conn, bool& keep_alive) {
+        http_parser::request request;
+        while (keep_alive && !conn.recv_buffer.empty()) {
+            http_parser::status result = conn.parser.parse(conn.recv_buffer.peek(), request);
+            if (result == http_parser::status::incomplete) {
+                return true;
+            }
+            if (result == http_parser::status::error) {
+                return false;
+            }
+            keep_alive = request.keep_alive; // Nothing after a Connection: close request is answered
+            response_cache::response response = response_cache::global().lookup(request.target, keep_alive);
+            conn.out.append_static(response.head.data(), response.head.size());
+            conn.out.append_file(response.file_fd, 0, response.file_size);
+            conn.recv_buffer.consume(request.size);
+        }
+        return true;
+    }
+
+    // Writes as much queued output as the socket takes. EPOLLOUT is armed while
+    // output is left over and disarmed once it drains. False if the connection was closed.
+    bool flush_output(int client_fd, client_connection& conn) {
+        output_queue::flush_result result = conn.out.flush(client_fd);
+        if (result == output_queue::flush_result::error) {
+            perror("write error");
+            close_client(client_fd);
+            return false;
+        }
+        if (result == output_queue::flush_result::blocked) {
+            if (!conn.write_armed) {
+                conn.write_armed = true;
+                epoll_event_loop->register_handler(client_fd,
+                                                   EventIOType::READ | EventIOType::WRITE | EventIOType::EDGE_TRIGGERED,
+                                                   conn.handler);
+            }
+            return true;
+        }
+        if (conn.write_armed) {
+            conn.write_armed = false;
+            epoll_event_loop->register_handler(client_fd,
+                                               EventIOType::READ | EventIOType::EDGE_TRIGGERED,
+                                               conn.handler);
+        }
+        if (conn.close_after_flush) {
+            close_client(client_fd);
+            return false;
+        }
+        return true;
+    }
+
+    void on_writable(int client_fd) {
+        client_connection* conn = find_connection(client_fd);
+        if (!conn) {
+            return; // Closed by the read handler in the same dispatch round
+        }
+        if (!flush_output(client_fd, *conn)) {
+            return;
+        }
+        if (conn->reading_paused && conn->out.pending_bytes() < low_watermark) {
+            // Edge-triggered: input that arrived while paused is not signalled again
+            conn->reading_paused = false;
+            clientconnections(client_fd);
+        }
+    }
+
+    // EPOLLERR/EPOLLHUP, e.g. a client that reset an idle keep-alive connection
+    void on_error(int client_fd) {
+        if (!find_connection(client_fd)) {
+            return; // Already closed by the read or write handler in the same dispatch round
+        }
+        close_client(client_fd);
+    }
 
     void clientconnections(int client_fd) {
-        auto it = client_recv_buffers.find(client_fd);
-        if (it == client_recv_buffers.end()) {
-            std::cerr << "Error: No buffer found for client_fd " << client_fd << std::endl;
+        client_connection* found = find_connection(client_fd);
+        if (!found) {
+            std::cerr << "Error: No connection found for client_fd " << client_fd << std::endl;
             epoll_event_loop->unregister_handler(client_fd, EventIOType::READ);
             return;
         }
-        std::string& current_buffer = it->second;
+        client_connection& conn = *found;
+        if (conn.reading_paused || conn.close_after_flush) {
+            return; // Input is picked up again once the output queue drains
+        }
 
-        char buffer_chunk[4096]; 
-        while (true) {
-            ssize_t bytes_read = read(client_fd, buffer_chunk, sizeof(buffer_chunk));
-            if (bytes_read > 0) {
-                current_buffer.append(buffer_chunk, bytes_read);
-                size_t header_end_pos = current_buffer.find("\r\n\r\n");
-                if (header_end_pos != std::string::npos) {
-                    const char* response = 
-                        "HTTP/1.1 200 OK\r\n"
-                        "Content-Type: text/html\r\n"
-                        "Content-Length: 13\r\n"
-                        "Connection: close\r\n" 
-                        "\r\n"
-                        "Hello, World!";
-                    int bytes_written = write(client_fd, response, strlen(response));
-                    if (bytes_written < 0) {
-                        perror("write error");
-                    }
-                    epoll_event_loop->unregister_handler(client_fd, EventIOType::READ);
-                    client_recv_buffers.erase(client_fd); 
-                    break; 
+        // Edge-triggered: drain the socket into the ring, parsing in place after each read.
+        // Responses to pipelined requests queue up and leave in one gathered write.
+        bool keep_alive = true;
+        bool peer_closed = false;
+        bool malformed = false;
+        while (keep_alive && !malformed) {
+            if (conn.out.pending_bytes() >= high_watermark) {
+                // The client is not reading its responses: stop reading its requests
+                if (!flush_output(client_fd, conn)) {
+                    return;
                 }
-
+                if (conn.out.pending_bytes() >= high_watermark) {
+                    conn.reading_paused = true;
+                    return;
+                }
+            }
+            ssize_t bytes_read = conn.recv_buffer.read_from(client_fd);
+            if (bytes_read > 0) {
+                malformed = !parse_requests(conn, keep_alive);
             } else if (bytes_read == 0) {
-                epoll_event_loop->unregister_handler(client_fd, EventIOType::READ);
-                client_recv_buffers.erase(client_fd); 
-                break; 
+                // A full ring holding no complete request: the request does not fit
+                malformed = conn.recv_buffer.full();
+                peer_closed = !malformed;
+                break;
             } else { // bytes_read < 0
+                if (errno == EINTR) {
+                    continue;
+                }
                 if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    break; 
-                } else {
-                    perror("read error");
-                    epoll_event_loop->unregister_handler(client_fd, EventIOType::READ);
-                    client_recv_buffers.erase(client_fd); 
-                    break; 
+                    break;
                 }
+                perror("read error");
+                close_client(client_fd);
+                return;
             }
         }
+        if (malformed) {
+            conn.out.append_static(bad_request_response, sizeof(bad_request_response) - 1);
+            keep_alive = false;
+        }
+        conn.close_after_flush = !keep_alive || peer_closed;
+        flush_output(client_fd, conn);
     }
-};
\ No newline at end of file
+};
+
+#endif // EPOLL_SERVER_H
@@ -1,6 +1,53 @@
+
 #include "event_dispatcher.h"
 #include "dispatcher_select.h"
+#include "dispatcher_poll.h"
 #include "dispatcher_epoll.h"
+#include "dispatcher_iouring.h"
+#include <cstdlib>
+#include <optional>
+
+namespace {
+// Set from the command line, takes precedence over the environment
+std::optional<EventType> auto_override;
+
+// Probe order for AUTO, fastest first. Creating an epoll instance never fails where
+// io_uring works, so io_uring has to be probed first to be picked at all.
+const EventType auto_candidates[] = {
+#ifdef HAVE_LIBURING
+    EventType::IoUring,
+#endif
+    EventType::Epoll,
+    EventType::Poll,
+    EventType::Select,
+};
+
+std::unique_ptr<Eventloop> create_auto_event_loop() {
+    EventType forced = EventType::AUTO;
+    if (auto_override) {
+        forced = *auto_override;
+    } else if (const char* env = std::getenv("EVENT_LOOP_BACKEND")) {
+        forced = EventLoopFactory::parse_event_type(env);
+    }
+    if (forced != EventType::AUTO) {
+        std::cout << "Event loop backend forced to " << EventLoopFactory::event_type_name(forced) << std::endl;
+        return EventLoopFactory::create_event_loop(forced);
+    }
+
+    // Constructing the loop is the probe: a backend the kernel lacks fails with ENOSYS/EINVAL
+    for (EventType candidate : auto_candidates) {
+        try {
+            auto loop = EventLoopFactory::create_event_loop(candidate);
+            std::cout << "Event loop backend auto-selected: " << EventLoopFactory::event_type_name(candidate) << std::endl;
+            return loop;
+        } catch (const std::exception& e) {
+            std::cerr << "Event loop backend " << EventLoopFactory::event_type_name(candidate)
+                      << " unavailable: " << e.what() << std::endl;
+        }
+    }
+    throw std::runtime_error("No usable event loop backend");
+}
+} // namespace
 
 std::unique_ptr<Eventloop> EventLoopFactory::create_event_loop(EventType type) {
     switch (type) {
@@ -8,17 +55,52 @@ std::unique_ptr<Eventloop> EventLoopFactory::create_event_loop(EventType type) {
             return std::make_unique<dispatcherselect>();
             break;
         case EventType::Poll:
-            // return std::make_unique<dispatcherpoll>();
+            return std::make_unique<dispatcherpoll>();
             break;
         case EventType::Epoll:
             return std::make_unique<dispatcherepoll>();
             break;
+        case EventType::IoUring:
+#ifdef HAVE_LIBURING
+            return std::make_unique<dispatcheriouring>();
+#else
+            throw std::runtime_error("io_uring backend not compiled in (liburing missing)");
+#endif
+            break;
         case EventType::AUTO:
-            // Default to Select for AUTO
-            return std::make_unique<dispatcherselect>();
+            return create_auto_event_loop();
             break;
         default:
             throw std::invalid_argument("Unknown event type");
     }
 }
 
+void EventLoopFactory::set_auto_override(EventType type) {
+    auto_override = type;
+}
+
+EventType EventLoopFactory::parse_event_type(const std::string& name) {
+    if (name == "select") {
+        return EventType::Select;
+    } else if (name == "poll") {
+        return EventType::Poll;
+    } else if (name == "epoll") {
+        return EventType::Epoll;
+    } else if (name == "iouring") {
+        return EventType::IoUring;
+    } else if (name == "auto") {
+        return EventType::AUTO;
+    }
+    throw std::invalid_argument("Unknown event loop backend: " + name);
+}
+
+const char* EventLoopFactory::event_type_name(EventType type) {
+    switch (type) {
+        case EventType::Select: return "select";
+        case EventType::Poll: return "poll";
+        case EventType::Epoll: return "epoll";
+        case EventType::IoUring: return "iouring";
+        case EventType::AUTO: return "auto";
+    }
+    return "unknown";
+}
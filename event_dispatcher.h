@@ -39,6 +39,7 @@ enum class EventType {
     Select,
     Poll,
     Epoll,
+    IoUring,
     AUTO
 };
 
@@ -47,7 +48,8 @@ enum class EventIOType {
     WRITE = 0x02, // Write event
     HANGUP = 0x04, // Hangup event
     EDGE_TRIGGERED = 0x08, // Edge-triggered event
-    EXCEPTION = 0x10 // Exception event
+    EXCEPTION = 0x10, // Exception event
+    EXCLUSIVE = 0x20 // Wake only one of the loops sharing this fd (epoll only, first registration only)
 };
 
 inline EventIOType operator|(EventIOType lhs, EventIOType rhs) {
@@ -63,7 +65,7 @@ inline bool has_event(EventIOType type, EventIOType event) {
 class Eventloop {
 public:
     Eventloop() = default;
-    ~Eventloop() = default;
+    virtual ~Eventloop() = default;
     Eventloop(const Eventloop&) = delete;
     Eventloop& operator=(const Eventloop&) = delete;
 
@@ -80,11 +82,21 @@ public:
     EventLoopFactory() = default;
     ~EventLoopFactory() = default;
     static std::unique_ptr<Eventloop> create_event_loop(EventType type);
+
+    // Backend AUTO resolves to: explicit override, then $EVENT_LOOP_BACKEND, then the
+    // fastest backend that can actually be created on this kernel.
+    static void set_auto_override(EventType type);
+    static EventType parse_event_type(const std::string& name);
+    static const char* event_type_name(EventType type);
 };
 
 class client_event_handler : public EventHandler {
 public:
-    client_event_handler(Eventloop* loop, std::function<void(int)> callback) : event_loop(loop), on_read_callback(callback) {
+    client_event_handler(Eventloop* loop, std::function<void(int)> callback,
+                         std::function<void(int)> write_callback = nullptr,
+                         std::function<void(int)> exception_callback = nullptr)
+                : event_loop(loop), on_read_callback(callback), on_write_callback(write_callback),
+                  on_exception_callback(exception_callback) {
         if (!event_loop) {
             throw std::runtime_error("Event loop is not initialized");
         }
@@ -96,10 +108,17 @@ public:
         }
     }
     void handle_write(int fd) override {
+        if (on_write_callback) {
+            on_write_callback(fd); // Socket became writable, flush queued output
+            return;
+        }
         std::cout << "Handling write event for fd: " << fd << std::endl;
-        // Implement write handling logic here
     }
     void handle_exception(int fd) override {
+        if (on_exception_callback) {
+            on_exception_callback(fd); // Error or hangup on one connection, the owner closes it
+            return;
+        }
         std::cout << "Handling exception event for fd: " << fd << std::endl;
         event_loop->stop(); // Stop the event loop on exception
         // Implement exception handling logic here
@@ -107,6 +126,8 @@ public:
 private:
     Eventloop* event_loop;
     std::function<void(int)> on_read_callback; // Callback for read events
+    std::function<void(int)> on_write_callback; // Callback for write events, optional
+    std::function<void(int)> on_exception_callback; // Callback for error/hangup events, optional
 };
 
 #endif // DISPATCHER_SELECT_H
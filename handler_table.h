@@ -0,0 +1,103 @@
+#ifndef HANDLER_TABLE_H
+#define HANDLER_TABLE_H
+
+#include <sys/resource.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <algorithm>    // For std::min, std::max
+#include "event_dispatcher.h"
+
+// Dense fd-indexed handler table: slot index == fd, so a lookup is a bounds check
+// plus an array index. The dispatch path only touches the raw pointer; the
+// shared_ptr is kept purely for ownership and is never copied per event.
+// Every slot carries a generation that changes whenever the fd gets a new handler,
+// so a token (generation << 32 | fd) taken for a previous owner of a recycled fd
+// no longer resolves.
+class handler_table {
+public:
+    struct slot {
+        EventHandler* handler = nullptr;      // Borrowed pointer used on the hot path
+        std::shared_ptr<EventHandler> owner;  // Keeps the handler alive while registered
+        uint32_t generation = 0;              // Bumped on every new registration and removal
+    };
+
+    explicit handler_table(size_t initial_size = 1024) : limit_(fd_limit()) {
+        slots_.resize(std::min(initial_size, limit_));
+    }
+
+    static uint64_t make_token(int fd, uint32_t generation) {
+        return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+    }
+    static int token_fd(uint64_t token) {
+        return static_cast<int>(static_cast<uint32_t>(token));
+    }
+    static uint32_t token_generation(uint64_t token) {
+        return static_cast<uint32_t>(token >> 32);
+    }
+
+    // Returns the slot if fd currently has a handler, nullptr otherwise
+    slot* find(int fd) {
+        if (fd < 0 || static_cast<size_t>(fd) >= slots_.size() || !slots_[fd].handler) {
+            return nullptr;
+        }
+        return &slots_[fd];
+    }
+
+    // Resolves an event token, stale tokens of a recycled fd yield nullptr
+    EventHandler* lookup(uint64_t token) const {
+        size_t fd = static_cast<uint32_t>(token);
+        if (fd >= slots_.size()) {
+            return nullptr;
+        }
+        const slot& s = slots_[fd];
+        return s.generation == token_generation(token) ? s.handler : nullptr;
+    }
+
+    // Installs handler for fd and returns the token to hand to the kernel.
+    // Re-installing the same handler keeps the generation (interest update only).
+    uint64_t insert(int fd, std::shared_ptr<EventHandler> handler) {
+        grow_to(fd);
+        slot& s = slots_[fd];
+        if (s.handler != handler.get()) {
+            ++s.generation;
+            s.handler = handler.get();
+            s.owner = std::move(handler);
+        }
+        return make_token(fd, s.generation);
+    }
+
+    void remove(int fd) {
+        slot* s = find(fd);
+        if (!s) {
+            return;
+        }
+        ++s->generation; // Invalidate tokens still sitting in the kernel's ready list
+        s->handler = nullptr;
+        s->owner.reset();
+    }
+
+private:
+    static size_t fd_limit() {
+        struct rlimit rl;
+        if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) {
+            return static_cast<size_t>(rl.rlim_cur);
+        }
+        return 1 << 20; // Kernel default for fs.nr_open
+    }
+
+    void grow_to(int fd) {
+        size_t needed = static_cast<size_t>(fd) + 1;
+        if (needed <= slots_.size()) {
+            return;
+        }
+        // Double until RLIMIT_NOFILE, past it only grow as far as the fd requires
+        size_t new_size = std::max(needed, std::min(std::max<size_t>(slots_.size() * 2, 64), limit_));
+        slots_.resize(new_size);
+    }
+
+    size_t limit_;
+    std::vector<slot> slots_;
+};
+
+#endif // HANDLER_TABLE_H
@@ -0,0 +1,277 @@
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <strings.h>    // For strncasecmp
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Incremental HTTP/1.x request parser. It never copies: parse() is handed a view
+// that starts at the first byte of the current request and may have grown since
+// the previous call; scanning resumes where it stopped, so every byte is looked at
+// once no matter how the request was split across reads. A complete request is
+// described by string_views into the caller's buffer, valid until it changes.
+class http_parser {
+public:
+    enum class status {
+        incomplete, // Need more bytes
+        complete,   // out describes one request of out.size bytes
+        error       // Malformed or unsupported request, the connection should be dropped
+    };
+
+    struct request {
+        std::string_view method;
+        std::string_view target;
+        std::string_view version;
+        std::string_view headers;   // Raw header lines, without the request line and the blank line
+        std::string_view body;
+        size_t content_length = 0;
+        bool keep_alive = false;    // Whether the client expects the connection to stay open
+        size_t size = 0;            // Bytes the request occupies, body included
+    };
+
+    static constexpr size_t max_header_bytes = 8192;      // Request line and headers
+    static constexpr size_t max_body_bytes = 1024 * 1024; // Largest Content-Length accepted
+    static constexpr size_t npos = std::string_view::npos;
+
+    status parse(std::string_view data, request& out) {
+        while (state_ != state::body) {
+            size_t lf = find_lf(data.data(), search_from_, data.size());
+            if (lf == npos) {
+                search_from_ = data.size(); // Resume after the bytes already scanned
+                return data.size() > max_header_bytes ? status::error : status::incomplete;
+            }
+            if (lf >= max_header_bytes) {
+                return status::error; // Many short lines add up as well
+            }
+            // Accept a bare LF as line end, strip the CR of a CRLF
+            size_t line_end = lf > line_start_ && data[lf - 1] == '\r' ? lf - 1 : lf;
+            std::string_view line = data.substr(line_start_, line_end - line_start_);
+            size_t next_line = lf + 1;
+            if (state_ == state::request_line) {
+                if (line.empty()) {
+                    // Tolerate stray CRLFs between pipelined requests
+                    leading_blank_ = next_line;
+                } else if (!parse_request_line(line)) {
+                    return status::error;
+                } else {
+                    headers_start_ = next_line;
+                    state_ = state::headers;
+                }
+            } else if (line.empty()) {
+                headers_end_ = line_start_;
+                body_start_ = next_line;
+                state_ = state::body;
+            } else if (!parse_header(line)) {
+                return status::error;
+            }
+            line_start_ = search_from_ = next_line;
+        }
+        if (data.size() - body_start_ < content_length_) {
+            return status::incomplete;
+        }
+        out.method = data.substr(leading_blank_, method_end_ - leading_blank_);
+        out.target = data.substr(target_start_, target_end_ - target_start_);
+        out.version = data.substr(version_start_, version_end_ - version_start_);
+        out.headers = data.substr(headers_start_, headers_end_ - headers_start_);
+        out.body = data.substr(body_start_, content_length_);
+        out.content_length = content_length_;
+        out.keep_alive = keep_alive_;
+        out.size = body_start_ + content_length_;
+        reset();
+        return status::complete;
+    }
+
+    // Forget a partially parsed request
+    void reset() {
+        *this = http_parser();
+    }
+
+private:
+    enum class state { request_line, headers, body };
+
+    // First '\n' in p[from, n), npos if none
+    static size_t find_lf(const char* p, size_t from, size_t n) {
+        size_t i = from;
+#ifdef __SSE2__
+        // 16 bytes per compare; the tail is handled byte by byte
+        const __m128i lf = _mm_set1_epi8('\n');
+        for (; i + 16 <= n; i += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf));
+            if (mask) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+        for (; i < n; ++i) {
+            if (p[i] == '\n') {
+                return i;
+            }
+        }
+        return npos;
+#else
+        if (i >= n) {
+            return npos;
+        }
+        const void* hit = memchr(p + i, '\n', n - i);
+        return hit ? static_cast<const char*>(hit) - p : npos;
+#endif
+    }
+
+    static bool iequals(std::string_view a, const char* b) {
+        size_t len = strlen(b);
+        return a.size() == len && strncasecmp(a.data(), b, len) == 0;
+    }
+    static bool contains_token(std::string_view value, const char* token) {
+        size_t len = strlen(token);
+        for (size_t i = 0; i + len <= value.size(); ++i) {
+            if (strncasecmp(value.data() + i, token, len) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // METHOD SP TARGET SP HTTP/1.x, offsets are relative to the request start
+    bool parse_request_line(std::string_view line) {
+        size_t base = line_start_;
+        size_t sp1 = line.find(' ');
+        if (sp1 == 0 || sp1 == npos) {
+            return false;
+        }
+        size_t sp2 = line.find(' ', sp1 + 1);
+        if (sp2 == npos || sp2 == sp1 + 1) {
+            return false;
+        }
+        std::string_view version = line.substr(sp2 + 1);
+        if (version.size() != 8 || version.compare(0, 7, "HTTP/1.") != 0) {
+            return false;
+        }
+        method_end_ = base + sp1;
+        target_start_ = base + sp1 + 1;
+        target_end_ = base + sp2;
+        version_start_ = base + sp2 + 1;
+        version_end_ = base + line.size();
+        keep_alive_ = version[7] != '0'; // HTTP/1.1 is persistent by default, 1.0 is not
+        return true;
+    }
+
+    bool parse_header(std::string_view line) {
+        size_t colon = line.find(':');
+        if (colon == 0 || colon == npos) {
+            return false;
+        }
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = line.substr(colon + 1);
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+            value.remove_prefix(1);
+        }
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+            value.remove_suffix(1);
+        }
+        if (iequals(name, "content-length")) {
+            // A second Content-Length, even an equal one, is how requests get smuggled
+            // past a proxy that honours the other one
+            if (value.empty() || has_content_length_) {
+                return false;
+            }
+            size_t length = 0;
+            for (char c : value) {
+                if (c < '0' || c > '9') {
+                    return false;
+                }
+                length = length * 10 + (c - '0');
+                if (length > max_body_bytes) {
+                    return false; // The whole body would have to be buffered
+                }
+            }
+            content_length_ = length;
+            has_content_length_ = true;
+        } else if (iequals(name, "connection")) {
+            if (contains_token(value, "close")) {
+                keep_alive_ = false;
+            } else if (contains_token(value, "keep-alive")) {
+                keep_alive_ = true;
+            }
+        } else if (iequals(name, "transfer-encoding")) {
+            return false; // Chunked request bodies are not supported
+        }
+        return true;
+    }
+
+    state state_ = state::request_line;
+    size_t line_start_ = 0;     // Start of the line being parsed
+    size_t search_from_ = 0;    // Where the next '\n' search resumes
+    size_t leading_blank_ = 0;  // Bytes of stray CRLF before the request line
+    size_t method_end_ = 0;
+    size_t target_start_ = 0;
+    size_t target_end_ = 0;
+    size_t version_start_ = 0;
+    size_t version_end_ = 0;
+    size_t headers_start_ = 0;
+    size_t headers_end_ = 0;
+    size_t body_start_ = 0;
+    size_t content_length_ = 0;
+    bool has_content_length_ = false;
+    bool keep_alive_ = false;
+};
+
+// Receive side of one HTTP connection. Bytes are parsed where they were read;
+// only the tail of a request that is still incomplete at the end of a read is
+// copied, into a buffer that is reused for the lifetime of the connection.
+class http_connection {
+public:
+    // Feeds freshly read bytes and calls on_request(const http_parser::request&) for
+    // every complete request; on_request returns false to stop early (e.g. close).
+    // Returns error for a malformed request, complete if on_request stopped, and
+    // incomplete once all bytes are consumed.
+    template<typename F>
+    http_parser::status consume(std::string_view data, F&& on_request) {
+        if (pending_.empty()) {
+            size_t used = 0;
+            http_parser::status result = parse_all(data, used, on_request);
+            if (result == http_parser::status::incomplete) {
+                pending_.append(data.data() + used, data.size() - used);
+            }
+            return result;
+        }
+        pending_.append(data.data(), data.size());
+        size_t used = 0;
+        http_parser::status result = parse_all(pending_, used, on_request);
+        pending_.erase(0, used);
+        return result;
+    }
+
+    bool has_pending() const { return !pending_.empty(); }
+    void clear() {
+        pending_.clear();
+        parser_.reset();
+    }
+
+private:
+    template<typename F>
+    http_parser::status parse_all(std::string_view data, size_t& used, F& on_request) {
+        http_parser::request request;
+        while (used < data.size()) {
+            http_parser::status result = parser_.parse(data.substr(used), request);
+            if (result != http_parser::status::complete) {
+                return result;
+            }
+            used += request.size;
+            if (!on_request(request)) {
+                return http_parser::status::complete;
+            }
+        }
+        return http_parser::status::incomplete;
+    }
+
+    http_parser parser_;
+    std::string pending_; // Start of a request split across reads
+};
+
+#endif // HTTP_PARSER_H
@@ -0,0 +1,182 @@
+#ifndef INLINE_TASK_H
+#define INLINE_TASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>      // For std::memcpy
+#include <new>          // For placement new
+#include <type_traits>
+#include <utility>      // For std::move, std::forward
+#include <vector>
+
+// Move-only replacement for std::function<void()> in task queues. The object is
+// one 64-byte cache line; a callable of up to inline_size bytes (the
+// [client_fd, this] closures the servers enqueue are 16) is constructed directly
+// in it, so enqueueing never allocates. Anything larger, over-aligned or not
+// nothrow-movable falls back to the heap. Dispatch goes
+// through one static table per callable type instead of std::function's manager,
+// and being move-only it accepts closures that own unique_ptrs.
+class inline_task {
+public:
+    static constexpr size_t inline_size = 64 - sizeof(void*); // Rest of the line after ops_
+
+    inline_task() noexcept = default;
+
+    template<typename F, typename Fn = std::decay_t<F>,
+             typename = std::enable_if_t<!std::is_same_v<Fn, inline_task>>>
+    inline_task(F&& f) {
+        if constexpr (fits_inline<Fn>()) {
+            new (storage_) Fn(std::forward<F>(f));
+            ops_ = &inline_ops<Fn>;
+        } else {
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(f));
+            ops_ = &heap_ops<Fn>;
+        }
+    }
+
+    inline_task(inline_task&& other) noexcept : ops_(other.ops_) {
+        take(other);
+    }
+    inline_task& operator=(inline_task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ops_ = other.ops_;
+            take(other);
+        }
+        return *this;
+    }
+    inline_task(const inline_task&) = delete;
+    inline_task& operator=(const inline_task&) = delete;
+
+    ~inline_task() { reset(); }
+
+    void operator()() { ops_->invoke(storage_); }
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+private:
+    // move and destroy are null when a byte copy / doing nothing is enough, which
+    // covers the usual closures of ints and pointers and every heap-held callable
+    struct operations {
+        void (*invoke)(void* self);
+        void (*move)(void* dst, void* src); // Move-constructs into dst and destroys src
+        void (*destroy)(void* self);
+    };
+
+    template<typename Fn>
+    static constexpr bool fits_inline() {
+        return sizeof(Fn) <= inline_size && alignof(Fn) <= alignof(void*)
+               && std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template<typename Fn>
+    static constexpr operations inline_ops = {
+        [](void* self) { (*static_cast<Fn*>(self))(); },
+        std::is_trivially_copyable_v<Fn> ? nullptr : +[](void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        std::is_trivially_destructible_v<Fn> ? nullptr : +[](void* self) { static_cast<Fn*>(self)->~Fn(); },
+    };
+    template<typename Fn>
+    static constexpr operations heap_ops = {
+        [](void* self) { (**static_cast<Fn**>(self))(); },
+        nullptr, // Only the pointer moves
+        [](void* self) { delete *static_cast<Fn**>(self); },
+    };
+
+    // Takes over other's callable; ops_ already holds other.ops_
+    void take(inline_task& other) noexcept {
+        if (!ops_) {
+            return;
+        }
+        if (ops_->move) {
+            ops_->move(storage_, other.storage_);
+        } else {
+            std::memcpy(storage_, other.storage_, inline_size);
+        }
+        other.ops_ = nullptr;
+    }
+
+    void reset() noexcept {
+        if (ops_) {
+            if (ops_->destroy) {
+                ops_->destroy(storage_);
+            }
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(void*) unsigned char storage_[inline_size];
+    const operations* ops_ = nullptr;
+};
+static_assert(sizeof(inline_task) == 64, "inline_task should fill exactly one cache line");
+
+// FIFO of inline_tasks on a power-of-two ring that only ever grows. std::queue's
+// deque allocates and frees a node every few elements as the queue slides, which
+// would undo the point of storing closures inline; here the steady state is
+// allocation-free once the ring has reached the peak backlog. Each slot can carry
+// a timestamp (e.g. enqueue time) for callers that measure queueing delay.
+class task_queue {
+public:
+    explicit task_queue(size_t capacity = 64)
+                : slots_(round_up_pow2(capacity)), stamps_(slots_.size()) {}
+
+    bool empty() const { return head_ == tail_; }
+    size_t size() const { return tail_ - head_; }
+
+    void push(inline_task&& task, uint64_t stamp = 0) {
+        if (size() == slots_.size()) {
+            grow();
+        }
+        size_t idx = tail_++ & (slots_.size() - 1);
+        slots_[idx] = std::move(task);
+        stamps_[idx] = stamp;
+    }
+    template<typename F>
+    void emplace(F&& f, uint64_t stamp = 0) {
+        push(inline_task(std::forward<F>(f)), stamp);
+    }
+
+    // Moves the oldest task out; the queue must not be empty
+    inline_task pop(uint64_t* stamp = nullptr) {
+        size_t idx = head_++ & (slots_.size() - 1);
+        if (stamp) {
+            *stamp = stamps_[idx];
+        }
+        return std::move(slots_[idx]);
+    }
+    // Stamp of the oldest task; the queue must not be empty
+    uint64_t front_stamp() const {
+        return stamps_[head_ & (slots_.size() - 1)];
+    }
+
+private:
+    static size_t round_up_pow2(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+    void grow() {
+        std::vector<inline_task> bigger(slots_.size() * 2);
+        std::vector<uint64_t> bigger_stamps(bigger.size());
+        size_t count = size();
+        for (size_t i = 0; i < count; ++i) {
+            size_t idx = (head_ + i) & (slots_.size() - 1);
+            bigger[i] = std::move(slots_[idx]);
+            bigger_stamps[i] = stamps_[idx];
+        }
+        slots_.swap(bigger);
+        stamps_.swap(bigger_stamps);
+        head_ = 0;
+        tail_ = count;
+    }
+
+    std::vector<inline_task> slots_;
+    std::vector<uint64_t> stamps_; // Parallel to slots_
+    size_t head_ = 0; // Unbounded, index with the mask
+    size_t tail_ = 0;
+};
+
+#endif // INLINE_TASK_H
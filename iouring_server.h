@@ -0,0 +1,89 @@
+#ifndef IOURING_SERVER_H
+#define IOURING_SERVER_H
+
+#ifdef HAVE_LIBURING
+
+#include "dispatcher_iouring.h"
+#include "socket.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+// Completion-based server: accept, recv and send are all io_uring operations,
+// the loop never issues a read/write syscall of its own.
+class iouring_event_handler : public Socket, public CompletionHandler {
+public:
+    iouring_event_handler(int port = 8080) : Socket(port) {
+        // IOURING_SQPOLL=1 adds a kernel submission thread, IOURING_WAIT=epoll
+        // waits through the eventfd+epoll bridge instead of io_uring_enter
+        const char* sqpoll = std::getenv("IOURING_SQPOLL");
+        const char* wait = std::getenv("IOURING_WAIT");
+        auto wait_mode = wait && std::string(wait) == "epoll" ? dispatcheriouring::WaitMode::EpollBridge
+                                                              : dispatcheriouring::WaitMode::Native;
+        // Owned directly: the completion interface is specific to this backend
+        iouring_event_loop = std::make_unique<dispatcheriouring>(256, 1024, 1024, 4096, 4096, wait_mode,
+                                                                 sqpoll && std::string(sqpoll) == "1");
+    }
+    ~iouring_event_handler() override {
+        std::cout << "iouring_event_handler destructor called." << std::endl;
+    }
+
+    void start() override {
+        create_fd();
+        set_non_blocking(get_fd());
+        std::cout << "Socket started on port " << _port << " with io_uring" << std::endl;
+        iouring_event_loop->submit_accept(sockfd, this);
+        iouring_event_loop->loop(); // Start the event loop
+    }
+
+    void handle_accept(int client_fd) override {
+        if (static_cast<size_t>(client_fd) >= connections.size()) {
+            connections.resize(client_fd + 1);
+        }
+        connections[client_fd].clear();
+        iouring_event_loop->open_connection(client_fd, this);
+    }
+
+    void handle_recv(int fd, const char* data, int len) override {
+        if (len <= 0) {
+            iouring_event_loop->close_connection(fd);
+            return;
+        }
+        // Parsed in the provided buffer itself, only a request split across recvs is copied.
+        // Connection: close, so only the first complete request is answered.
+        http_parser::status result = connections[fd].consume(std::string_view(data, len),
+                                                             [](const http_parser::request&) { return false; });
+        if (result == http_parser::status::complete) {
+            iouring_event_loop->submit_send(fd, response, sizeof(response) - 1);
+        } else if (result == http_parser::status::error) {
+            iouring_event_loop->submit_send(fd, bad_request_response, sizeof(bad_request_response) - 1);
+        }
+    }
+
+    void handle_send(int fd, int result) override {
+        if (result < 0) {
+            std::cerr << "Send error on client FD " << fd << ": " << strerror(-result) << std::endl;
+        }
+        iouring_event_loop->close_connection(fd); // Connection: close
+    }
+
+private:
+    static constexpr char response[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/html\r\n"
+        "Content-Length: 13\r\n"
+        "Connection: close\r\n"
+        "\r\n"
+        "Hello, World!";
+
+    std::unique_ptr<dispatcheriouring> iouring_event_loop;
+    std::vector<http_connection> connections; // fd-indexed parser state
+};
+
+#endif // HAVE_LIBURING
+
+#endif // IOURING_SERVER_H
@@ -3,44 +3,132 @@
 #include   <cstdlib>
 #include   "socket.h"
 #include    <thread>
+#include   <atomic>
+#include   <memory>
+#include   <sys/epoll.h>
+#include   <sys/eventfd.h>
 
+// Leader/follower without a shared lock. The leader is the only thread waiting
+// on the epoll set that holds the listener; once it has accepted a connection it
+// promotes exactly one follower and goes off to handle the connection. Followers
+// park on their own futex word (std::atomic::wait) in a lock-free LIFO stack, so
+// a handoff is one CAS plus one targeted wakeup, and the most recently active
+// (cache-warm) thread is the next leader.
 class lead_follow : public Socket
 {
 private:
-    /* data */
+    // Per-thread parking spot, one cache line each so waking one does not disturb another
+    struct alignas(64) follower {
+        std::atomic<uint32_t> promoted{0}; // Futex word: 1 once this thread may lead
+        std::atomic<uint32_t> next{0};     // Stack link: index + 1 of the next follower, 0 = end
+    };
+
     int thread_count = std::thread::hardware_concurrency(); // Get the number of available CPU cores
-    bool is_running = true; // Flag to indicate if the server is running
-    std::condition_variable cv; // Condition variable for thread synchronization
+    std::atomic<bool> is_running{true}; // Flag to indicate if the server is running
     std::vector<std::thread> threads_;
-    std::mutex lead_mutex_; 
-    size_t lead_index = 0; // Index of the lead thread
+    std::unique_ptr<follower[]> followers_;
+    std::atomic<uint64_t> stack_top_{0}; // (ABA tag << 32) | (index + 1) of the top follower, 0 = empty
+    std::atomic<bool> leader_vacant_{true}; // Nobody leads and nobody has been promoted
+    int epoll_fd_ = -1;
+    int stop_fd_ = -1; // eventfd that releases the leader from epoll_wait on stop()
 
 protected:
 
+    void push_follower(uint32_t index) {
+        uint64_t top = stack_top_.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            followers_[index].next.store(static_cast<uint32_t>(top), std::memory_order_relaxed);
+            next = ((top >> 32) + 1) << 32 | (index + 1);
+        } while (!stack_top_.compare_exchange_weak(top, next, std::memory_order_seq_cst));
+    }
+
+    // Index of the popped follower, -1 if the stack is empty
+    int pop_follower() {
+        uint64_t top = stack_top_.load(std::memory_order_seq_cst);
+        while (static_cast<uint32_t>(top) != 0) {
+            uint32_t index = static_cast<uint32_t>(top) - 1;
+            uint64_t next = ((top >> 32) + 1) << 32 | followers_[index].next.load(std::memory_order_relaxed);
+            if (stack_top_.compare_exchange_weak(top, next, std::memory_order_seq_cst)) {
+                return static_cast<int>(index);
+            }
+        }
+        return -1;
+    }
+
+    void wake(int index) {
+        followers_[index].promoted.store(1, std::memory_order_release);
+        followers_[index].promoted.notify_one();
+    }
+
+    // A vacant leadership and a parked follower must never coexist. Both the
+    // leader giving up the role and a follower about to park call this after
+    // publishing their side, whoever sees both hands the role to the top follower.
+    void fill_vacancy() {
+        while (leader_vacant_.load(std::memory_order_seq_cst)
+               && static_cast<uint32_t>(stack_top_.load(std::memory_order_seq_cst)) != 0) {
+            bool expected = true;
+            if (!leader_vacant_.compare_exchange_strong(expected, false, std::memory_order_seq_cst)) {
+                return; // Someone else filled it
+            }
+            int index = pop_follower();
+            if (index >= 0) {
+                wake(index);
+                return;
+            }
+            leader_vacant_.store(true, std::memory_order_seq_cst); // Stack drained meanwhile, retry
+        }
+    }
+
     void change_lead() {
-        // This function can be used to change the lead thread
-        std::unique_lock<std::mutex> lock(lead_mutex_);
-        lead_index = (lead_index + 1) % thread_count; // Change the lead index to the next thread
-        cv.notify_all(); // Notify all threads to wake up and check if they are the lead
+        // Give up leadership: exactly one parked follower (if any) is woken
+        leader_vacant_.store(true, std::memory_order_seq_cst);
+        fill_vacancy();
+    }
+
+    // Returns once this thread is the leader (or the server stops)
+    void wait_for_leadership(int thread_id) {
+        bool expected = true;
+        if (leader_vacant_.compare_exchange_strong(expected, false, std::memory_order_seq_cst)) {
+            return; // Nobody was leading: take over without parking
+        }
+        follower& self = followers_[thread_id];
+        self.promoted.store(0, std::memory_order_relaxed);
+        push_follower(thread_id);
+        fill_vacancy(); // The leader may have stepped down before we were visible
+        while (self.promoted.load(std::memory_order_acquire) == 0) {
+            self.promoted.wait(0, std::memory_order_acquire);
+        }
     }
 
     void worker_thread(int thread_id) {
         // This function will be executed by each worker thread
         while (is_running) {
-            std::unique_lock<std::mutex> lock(lead_mutex_);
-            cv.wait(lock, [this, thread_id] { return !is_running || thread_id == lead_index; }); // Wait until the server is running
+            wait_for_leadership(thread_id);
             if (!is_running) {
+                change_lead(); // Pass the stop on to the next parked thread
                 break; // Exit the thread if the server is not running
             }
-            lock.unlock(); // Unlock the mutex to allow other threads to run
 
-            int client_fd = accept_connection();
+            // Leader: wait for the listener (or stop) on the shared epoll set
+            struct epoll_event event;
+            int ready = epoll_wait(epoll_fd_, &event, 1, -1);
+            if (ready <= 0 || event.data.fd == stop_fd_) {
+                if (ready < 0 && errno != EINTR) {
+                    perror("epoll_wait");
+                }
+                change_lead(); // On stop every thread passes through here once
+                continue;
+            }
+            int client_fd = accept(sockfd, nullptr, nullptr);
             if (client_fd < 0) {
-                std::cerr << "Error accepting connection." << std::endl;
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    std::cerr << "Error accepting connection." << std::endl;
+                }
                 change_lead(); // Change the lead thread if there is an error
                 continue; // Continue to accept more connections
             }
-            change_lead(); // Change the lead thread after accepting a connection
+            change_lead(); // Promote one follower, then process while it waits for the next connection
             handleconnections(client_fd); // Handle the connection
         }
     }
@@ -51,7 +139,12 @@ public:
         signal(SIGTERM, lead_follow::signal_handler);
     }
     ~lead_follow() {
-        // Cleanup code if needed
+        if (epoll_fd_ >= 0) {
+            close(epoll_fd_);
+        }
+        if (stop_fd_ >= 0) {
+            close(stop_fd_);
+        }
     }
 
     void static signal_handler(int signum) {
@@ -62,10 +155,31 @@ public:
     void start() {
         // Call the base class method to create the socket
         Socket::create_fd();
+        set_non_blocking(sockfd); // Only the leader accepts, after epoll reported a connection
 
-        for (size_t i = 0; i < thread_count; i++)
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epoll_fd_ < 0 || stop_fd_ < 0) {
+            throw std::runtime_error("Failed to create leader epoll set");
+        }
+        for (int fd : {sockfd, stop_fd_}) {
+            struct epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                throw std::runtime_error("Failed to add fd to leader epoll set");
+            }
+        }
+
+        if (thread_count <= 0) {
+            thread_count = 1;
+        }
+        followers_ = std::make_unique<follower[]>(thread_count);
+        cpu_placement placement = cpu_placement::configured();
+        for (int i = 0; i < thread_count; i++)
         {
             threads_.emplace_back(&lead_follow::worker_thread, this, i);
+            placement.pin_thread(threads_.back(), i);
         }
 
         for(auto & thread : threads_) {
@@ -77,7 +191,10 @@ public:
 
     void stop() {
         is_running = false; // Set the running flag to false to stop the server
-        cv.notify_all(); // Notify all threads to wake up and exit
+        uint64_t one = 1;
+        if (write(stop_fd_, &one, sizeof(one)) < 0) { // Level-triggered: every later leader sees it too
+            perror("write stop eventfd");
+        }
         for (auto & thread : threads_) {
             if (thread.joinable()) {
                 thread.join(); // Wait for all threads to finish
@@ -86,4 +203,3 @@ public:
     }
 
 };
-
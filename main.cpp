@@ -3,11 +3,17 @@
 #include "multi_thread.h"
 #include "process_pool.h"
 #include "process_pool_1.h"
+#include "prefork_server.h"
 #include "thread_pool.h"
+#include "work_stealing_server.h"
 #include "lead_follow.h"
 #include "select_server.h"
 #include "epoll_server.h"
+#include "multi_reactor.h"
+#include "reactor_server.h"
+#include "iouring_server.h"
 #include <memory>
+#include <csignal>
 
 
 void print_usage() {
@@ -15,6 +21,16 @@ void print_usage() {
     std::cout << "Available types:" << std::endl;
     std::cout << "1: singleSocket" << std::endl;
     std::cout << "Default port is 8080." << std::endl;
+    std::cout << "Options: --event-loop=<auto|iouring|epoll|poll|select> picks the backend for reactor" << std::endl;
+    std::cout << "         (also read from $EVENT_LOOP_BACKEND)." << std::endl;
+    std::cout << "         --static-root=<dir> serves the files below dir from the response cache" << std::endl;
+    std::cout << "         (also read from $STATIC_ROOT, default is the built-in Hello, World! page)." << std::endl;
+    std::cout << "         --cpu-placement=<none|compact|scatter|cpu list> pins pool workers and reactors" << std::endl;
+    std::cout << "         (also read from $CPU_PLACEMENT, e.g. 0,2,4-7)." << std::endl;
+    std::cout << "Environment: THREADPOOL_ELASTIC=<min:max> lets poolthread size its pool by queueing delay." << std::endl;
+    std::cout << "             PREFORK_WORKERS=<n> sets the number of prefork worker processes (default: one per CPU)." << std::endl;
+    std::cout << "             THREAD_CACHE=<max_threads[:stack_kb]> caps multiThreadSocket's threads (default 256:256)." << std::endl;
+    std::cout << "Signals: SIGUSR1 makes multiSocket, processPool and processPool1 print per-worker statistics." << std::endl;
     exit(EXIT_FAILURE);
 }
 
@@ -29,14 +45,30 @@ std::unique_ptr<Socket> create_server(const std::string& type, int port) {
         return std::make_unique<processPool>(port);
     } else if (type == "processPool1") {
         return std::make_unique<processPool1>(port);
+    } else if (type == "prefork") {
+        return std::make_unique<prefork_server>(port);
     } else if (type == "poolthread") {
         return std::make_unique<poolthread>(port);
+    } else if (type == "work_stealing") {
+        return std::make_unique<workstealing>(port);
     } else if (type == "lead_follow") {
         return std::make_unique<lead_follow>(port);
     } else if (type == "selectserver") {
         return std::make_unique<select_event_handler>(port);
+    } else if (type == "pollserver") {
+        return std::make_unique<reactor_event_handler>(port, EventType::Poll); // The reactor on the poll() backend
     } else if (type == "epollserver") {
         return std::make_unique<epoll_event_handler>(port);
+    } else if (type == "iouringserver") {
+#ifdef HAVE_LIBURING
+        return std::make_unique<iouring_event_handler>(port);
+#else
+        throw std::invalid_argument("iouringserver needs a build with liburing");
+#endif
+    } else if (type == "reactor") {
+        return std::make_unique<reactor_event_handler>(port);
+    } else if (type == "multireactor") {
+        return std::make_unique<multi_reactor>(port);
     } else {
         throw std::invalid_argument("Unknown socket type: " + type);
     }
@@ -50,11 +82,29 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
     std::string type = argv[1];
-    std::string port_str = argv[2];
-    int port = std::stoi(port_str);
-    auto server =  create_server(type, port);
+    int port = 8080;
 
     try {
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            const std::string event_loop_flag = "--event-loop=";
+            const std::string static_root_flag = "--static-root=";
+            const std::string cpu_placement_flag = "--cpu-placement=";
+            if (arg.rfind(event_loop_flag, 0) == 0) {
+                EventLoopFactory::set_auto_override(EventLoopFactory::parse_event_type(arg.substr(event_loop_flag.size())));
+            } else if (arg.rfind(cpu_placement_flag, 0) == 0) {
+                cpu_placement::set_override(arg.substr(cpu_placement_flag.size()));
+            } else if (arg.rfind(static_root_flag, 0) == 0) {
+                response_cache::global().load_directory(arg.substr(static_root_flag.size()));
+            } else {
+                port = std::stoi(arg);
+            }
+        }
+        // sendfile() has no MSG_NOSIGNAL: a client that hangs up mid-file must not kill the server
+        signal(SIGPIPE, SIG_IGN);
+        // Load the cache before any worker thread or process starts
+        response_cache::global();
+        auto server =  create_server(type, port);
         server->start();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
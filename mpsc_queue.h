@@ -0,0 +1,91 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>      // For std::move
+
+// Bounded lock-free multi-producer/single-consumer ring (Vyukov style).
+// Every cell carries a sequence number: producers claim a slot by CAS on tail_
+// and publish it by bumping the sequence, the single consumer pops in order.
+template <typename T>
+class mpsc_ring {
+public:
+    explicit mpsc_ring(size_t capacity = 4096)
+        : mask_(round_up_pow2(capacity < 2 ? 2 : capacity) - 1),
+          cells_(std::make_unique<Cell[]>(mask_ + 1)) {
+        for (size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    mpsc_ring(const mpsc_ring&) = delete;
+    mpsc_ring& operator=(const mpsc_ring&) = delete;
+
+    // Safe to call from any thread. Returns false (and leaves value untouched) when the ring is full.
+    bool try_push(T&& value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break; // Slot claimed
+                }
+            } else if (diff < 0) {
+                return false; // The consumer has not freed this slot yet, ring is full
+            } else {
+                pos = tail_.load(std::memory_order_relaxed); // Another producer won the slot
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release); // Publish to the consumer
+        return true;
+    }
+
+    // Only the consumer thread may call this.
+    bool try_pop(T& out) {
+        Cell& cell = cells_[head_ & mask_];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(head_ + 1) < 0) {
+            return false; // Nothing published yet
+        }
+        out = std::move(cell.value);
+        cell.value = T{}; // Drop whatever the moved-from value still owns
+        cell.sequence.store(head_ + mask_ + 1, std::memory_order_release); // Hand the slot back to producers
+        ++head_;
+        return true;
+    }
+
+    // Only the consumer thread may call this.
+    bool empty() const {
+        size_t seq = cells_[head_ & mask_].sequence.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(seq) - static_cast<intptr_t>(head_ + 1) < 0;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    static size_t round_up_pow2(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> tail_{0}; // Next slot producers will claim
+    alignas(64) size_t head_ = 0;             // Next slot the consumer will read
+};
+
+#endif // MPSC_QUEUE_H
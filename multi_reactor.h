@@ -0,0 +1,72 @@
+#ifndef MULTI_REACTOR_H
+#define MULTI_REACTOR_H
+
+#include   <signal.h>
+#include   <pthread.h>
+#include   <sched.h>
+#include   <iostream>
+#include   <cstdlib>
+#include   <memory>
+#include   <thread>
+#include   <vector>
+#include   "socket.h"
+#include   "epoll_server.h"
+
+// One dispatcherepoll per core: every reactor thread owns its own SO_REUSEPORT
+// listener, event loop and connection buffers, so nothing is shared between threads.
+class multi_reactor : public Socket {
+public:
+    multi_reactor(int port, int num_reactors = std::thread::hardware_concurrency())
+        : Socket(port), num_reactors_(num_reactors > 0 ? num_reactors : 1) {
+        signal(SIGINT, multi_reactor::signal_handler);
+        signal(SIGTERM, multi_reactor::signal_handler);
+    }
+    ~multi_reactor() override {
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.detach(); // Reactor loops never return, do not block on them
+            }
+        }
+    }
+
+    static void signal_handler(int signum) {
+        std::cout << "Signal received: " << signum << ". Shutting down gracefully." << std::endl;
+        exit(signum);
+    }
+
+    void start() override {
+        // Reactors were always pinned; keep that (compact) unless a placement is configured
+        cpu_placement placement = cpu_placement::configured(cpu_placement::policy::compact);
+        for (int i = 0; i < num_reactors_; ++i) {
+            reactors_.emplace_back(std::make_unique<epoll_event_handler>(_port, true));
+            // Steer connections handled on the reactor's CPU to its own listener
+            reactors_.back()->set_incoming_cpu(placement.cpu_for(i));
+        }
+        std::cout << "Multi reactor server started on port " << _port
+                  << " with " << num_reactors_ << " reactors" << std::endl;
+
+        for (int i = 0; i < num_reactors_; ++i) {
+            threads_.emplace_back([this, i] {
+                try {
+                    reactors_[i]->start(); // Creates the reuseport listener and runs the loop
+                } catch (const std::exception& e) {
+                    std::cerr << "Reactor " << i << " failed: " << e.what() << std::endl;
+                }
+            });
+            placement.pin_thread(threads_.back(), i);
+        }
+
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join(); // Wait for all reactors to finish
+            }
+        }
+    }
+
+private:
+    int num_reactors_;
+    std::vector<std::unique_ptr<epoll_event_handler>> reactors_; // One reactor per thread
+    std::vector<std::thread> threads_;
+};
+
+#endif // MULTI_REACTOR_H
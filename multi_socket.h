@@ -4,50 +4,118 @@
 #include   "socket.h"
 #include <signal.h>
 #include <sys/wait.h>
+#include <chrono>
+#include <vector>
+#include "shared_stats.h"
 
 class multiSocket : public Socket {
     public:
         multiSocket(int port);
         static void signal_handler(int signum);
+        static void child_handler(int signum);
         void start();
 
+    private:
+        static constexpr size_t max_stats_slots = 256; // Children running at once that get a slot
+
+        int claim_slot(pid_t pid);
+        void reap_children();
+
+        shared_stats stats{max_stats_slots}; // Mapped before fork(), dumped on SIGUSR1
+        std::vector<pid_t> slot_owner = std::vector<pid_t>(max_stats_slots, 0); // Live child per slot, 0 = free
+        static inline volatile sig_atomic_t child_exited = 0; // Set by SIGCHLD, cleared before reaping
 };
-void clean_child(int){
-    while (waitpid(-1, NULL, WNOHANG) > 0);
-}
 multiSocket::multiSocket(int port) : Socket(port) {
     // Constructor implementation
-    signal(SIGCHLD, clean_child);
+    // Children are reaped in start() so their stats slots can be handed out again.
+    // SIGCHLD only sets a flag; without SA_RESTART it interrupts a blocked accept(),
+    // so an exited child is reaped at once rather than at the next connection.
     signal(SIGINT, multiSocket::signal_handler);
     signal(SIGTERM, multiSocket::signal_handler);
+    struct sigaction sa = {};
+    sa.sa_handler = multiSocket::child_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_NOCLDSTOP;
+    sigaction(SIGCHLD, &sa, nullptr);
+    shared_stats::install_dump_signal();
 }
 
 void multiSocket::signal_handler(int signum) {
     std::cout << "Signal received: " << signum << ". Shutting down gracefully." << std::endl;
     exit(signum);
 }
+
+void multiSocket::child_handler(int) {
+    child_exited = 1;
+}
+
+void multiSocket::reap_children() {
+    pid_t pid;
+    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+        for (pid_t& owner : slot_owner) {
+            if (owner == pid) {
+                owner = 0;
+                break;
+            }
+        }
+    }
+}
+
+// Lowest free slot, so slot n counts connections served while n others were in
+// flight; -1 if all are taken and the child goes uncounted
+int multiSocket::claim_slot(pid_t pid) {
+    for (size_t slot = 0; slot < slot_owner.size(); ++slot) {
+        if (slot_owner[slot] == 0) {
+            slot_owner[slot] = pid;
+            return static_cast<int>(slot);
+        }
+    }
+    return -1;
+}
+
 void multiSocket::start() {
     // Call the base class method to create the socket
     Socket::create_fd();
     // Accept connections or handle other tasks here
     while (true) {
         int client_fd = accept_connection();
+        int accept_errno = errno; // waitpid() below overwrites errno
+        if (child_exited) {
+            child_exited = 0; // Cleared first: a child exiting during the reap sets it again
+            reap_children();
+        }
+        if (shared_stats::take_dump_request()) {
+            stats.dump(std::cout);
+        }
         if (client_fd < 0) {
-            std::cerr << "Error accepting connection." << std::endl;
+            if (accept_errno != EINTR) {
+                std::cerr << "Error accepting connection." << std::endl;
+            }
             continue;
         }
+        int slot = claim_slot(-1); // Reserved now, owner filled in once the pid is known
         pid_t child_pid = fork(); // Create a new process for each connection
         if (child_pid < 0) {
             std::cerr << "Error forking process." << std::endl;
             close(client_fd);
+            if (slot >= 0) {
+                slot_owner[slot] = 0;
+            }
         } else if (child_pid == 0) {
             // Child process
             close(sockfd); // Close the server socket in the child process
+            auto begin = std::chrono::steady_clock::now();
             handleconnections(client_fd); // Handle the connection
+            if (slot >= 0) {
+                stats.claim(slot).record(std::chrono::steady_clock::now() - begin);
+            }
             exit(0); // Exit child process after handling
         }else{
             // Parent process
+            if (slot >= 0) {
+                slot_owner[slot] = child_pid;
+            }
             close(client_fd); // Close the client socket in the parent process
         }
     }
-}
\ No newline at end of file
+}
@@ -3,23 +3,51 @@
 #include   <cstdlib>
 #include   "socket.h"
 #include <thread>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include "thread_cache.h"
 
 class multiThreadSocket : public Socket {
     public:
         multiThreadSocket(int port);
         static void signal_handler(int signum);
         void start();
+
+    private:
+        static thread_cache::config cache_config();
+        thread_cache threads; // Connection threads, reused once they finish
 };
 
 void multiThreadSocket::signal_handler(int signum) {
     std::cout << "Signal received: " << signum << ". Shutting down gracefully." << std::endl;
     exit(signum);
 }
-multiThreadSocket::multiThreadSocket(int port) : Socket(port) {
+multiThreadSocket::multiThreadSocket(int port) : Socket(port), threads(cache_config()) {
     // Constructor implementation
     signal(SIGINT, multiThreadSocket::signal_handler);
     signal(SIGTERM, multiThreadSocket::signal_handler);
 }
+
+// $THREAD_CACHE="max_threads[:stack_kb]" overrides the cap and the per-thread stack
+thread_cache::config multiThreadSocket::cache_config() {
+    thread_cache::config config;
+    const char* spec = std::getenv("THREAD_CACHE");
+    if (!spec || !*spec) {
+        return config;
+    }
+    size_t stack_kb = config.stack_size / 1024;
+    int fields = sscanf(spec, "%zu:%zu", &config.max_threads, &stack_kb);
+    if (fields < 1 || config.max_threads == 0 || stack_kb == 0) {
+        throw std::invalid_argument(std::string("THREAD_CACHE must be max_threads[:stack_kb], got ") + spec);
+    }
+    config.stack_size = stack_kb * 1024;
+    config.max_idle = std::min(config.max_idle, config.max_threads);
+    std::cout << "Thread cache: up to " << config.max_threads << " threads with "
+              << stack_kb << " KB stacks" << std::endl;
+    return config;
+}
+
 void multiThreadSocket::start() {
     // Call the base class method to create the socket
     Socket::create_fd();
@@ -31,10 +59,10 @@ void multiThreadSocket::start() {
             std::cerr << "Error accepting connection." << std::endl;
             continue; // Continue to accept more connections
         }
-        // Handle the connection in a new thread
-        std::thread([client_fd, this]() {
+        // Handle the connection on its own thread: a parked one if any, else a new one
+        // up to the cap, else it waits for the next thread to finish
+        threads.submit([client_fd, this]() {
             handleconnections(client_fd); // Handle the connection
-        }).detach(); // Detach the thread to allow it to run independently
+        });
     }
 }
-
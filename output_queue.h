@@ -0,0 +1,135 @@
+#ifndef OUTPUT_QUEUE_H
+#define OUTPUT_QUEUE_H
+
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <climits>      // For IOV_MAX
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Per-connection queue of bytes waiting to be written. Segments either borrow
+// data that outlives the queue (static responses, cached files) or own a copy;
+// file segments are sent straight from the page cache with sendfile.
+// flush() gathers them into one sendmsg (writev with MSG_NOSIGNAL, so a vanished
+// peer is an error rather than SIGPIPE) and keeps whatever the socket did not
+// take, so a short write never truncates a response. The vector keeps its
+// capacity once drained, so steady-state queueing does not allocate.
+class output_queue {
+public:
+    enum class flush_result {
+        done,    // Everything was written
+        blocked, // The socket buffer is full, wait for writability
+        error    // Hard write error, the connection should be dropped
+    };
+
+    // data must stay valid until it has been written or the queue is cleared
+    void append_static(const char* data, size_t len) {
+        if (len == 0) {
+            return;
+        }
+        segments_.push_back(segment{data, std::string(), len, -1, 0});
+        pending_ += len;
+    }
+    void append_copy(const char* data, size_t len) {
+        if (len == 0) {
+            return;
+        }
+        segments_.push_back(segment{nullptr, std::string(data, len), len, -1, 0});
+        pending_ += len;
+    }
+    // file_fd must stay open until the segment has been written or the queue is cleared
+    void append_file(int file_fd, off_t offset, size_t len) {
+        if (len == 0) {
+            return;
+        }
+        segments_.push_back(segment{nullptr, std::string(), len, file_fd, offset});
+        pending_ += len;
+    }
+
+    flush_result flush(int fd) {
+        while (head_ < segments_.size()) {
+            ssize_t written = segments_[head_].file_fd >= 0 ? send_file_segment(fd) : send_memory_segments(fd);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK ? flush_result::blocked : flush_result::error;
+            }
+            if (written == 0) {
+                return flush_result::error; // File shrank underneath a sendfile
+            }
+            advance(static_cast<size_t>(written));
+        }
+        return flush_result::done;
+    }
+
+    bool empty() const { return pending_ == 0; }
+    size_t pending_bytes() const { return pending_; }
+    void clear() {
+        segments_.clear();
+        head_ = 0;
+        head_offset_ = 0;
+        pending_ = 0;
+    }
+
+private:
+    static constexpr int max_iov = IOV_MAX < 64 ? IOV_MAX : 64; // iovecs per sendmsg call
+
+    struct segment {
+        const char* borrowed; // Borrowed bytes, nullptr if owned is used
+        std::string owned;
+        size_t len;
+        int file_fd;          // >= 0 for a sendfile segment
+        off_t file_offset;
+        const char* data() const { return borrowed ? borrowed : owned.data(); }
+    };
+
+    // Memory segments from the head up to the next file segment, in one sendmsg
+    ssize_t send_memory_segments(int fd) {
+        struct iovec iov[max_iov];
+        int count = 0;
+        for (size_t i = head_; i < segments_.size() && count < max_iov && segments_[i].file_fd < 0; ++i, ++count) {
+            const segment& seg = segments_[i];
+            size_t offset = i == head_ ? head_offset_ : 0;
+            iov[count].iov_base = const_cast<char*>(seg.data() + offset);
+            iov[count].iov_len = seg.len - offset;
+        }
+        struct msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        return sendmsg(fd, &msg, MSG_NOSIGNAL);
+    }
+    ssize_t send_file_segment(int fd) {
+        const segment& seg = segments_[head_];
+        off_t offset = seg.file_offset + static_cast<off_t>(head_offset_);
+        return sendfile(fd, seg.file_fd, &offset, seg.len - head_offset_);
+    }
+
+    void advance(size_t written) {
+        pending_ -= written;
+        while (written > 0) {
+            size_t left = segments_[head_].len - head_offset_;
+            if (written < left) {
+                head_offset_ += written;
+                return;
+            }
+            written -= left;
+            head_offset_ = 0;
+            ++head_;
+        }
+        if (head_ == segments_.size()) {
+            segments_.clear(); // Keeps the capacity for the next responses
+            head_ = 0;
+        }
+    }
+
+    std::vector<segment> segments_;
+    size_t head_ = 0;        // First segment not fully written
+    size_t head_offset_ = 0; // Bytes of segments_[head_] already written
+    size_t pending_ = 0;     // Bytes still queued
+};
+
+#endif // OUTPUT_QUEUE_H
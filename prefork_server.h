@@ -0,0 +1,106 @@
+#ifndef PREFORK_SERVER_H
+#define PREFORK_SERVER_H
+
+#include   <signal.h>
+#include   <sys/prctl.h>  // for prctl, PR_SET_PDEATHSIG
+#include   <sys/wait.h>
+#include   <unistd.h>
+#include   <iostream>
+#include   <cstdlib>
+#include   <string>
+#include   <thread>
+#include   <vector>
+#include   "socket.h"
+#include   "epoll_server.h"
+#include   "cpu_affinity.h"
+
+// Pre-forked workers that each run their own epoll reactor. The listener is created
+// once before fork() and every worker adds it to its own dispatcherepoll with
+// EPOLLEXCLUSIVE, so a new connection wakes one idle worker rather than all of them
+// and no accept mutex is needed. Unlike processPool, a worker multiplexes all of its
+// connections instead of serving one at a time.
+// The worker count is the constructor argument, else $PREFORK_WORKERS, else one per CPU.
+class prefork_server : public Socket {
+public:
+    prefork_server(int port, int num_workers = configured_workers())
+        : Socket(port), num_workers_(num_workers > 0 ? num_workers : 1) {
+        signal(SIGINT, prefork_server::signal_handler);
+        signal(SIGTERM, prefork_server::signal_handler);
+    }
+    ~prefork_server() override {
+        stop();
+    }
+
+    static void signal_handler(int signum) {
+        std::cout << "Signal received: " << signum << ". Shutting down gracefully." << std::endl;
+        exit(signum); // Workers get SIGTERM through PR_SET_PDEATHSIG
+    }
+
+    static int configured_workers() {
+        if (const char* env = std::getenv("PREFORK_WORKERS"); env && *env) {
+            try {
+                return std::stoi(env);
+            } catch (const std::logic_error&) {
+                std::cerr << "Ignoring bad PREFORK_WORKERS: " << env << std::endl;
+            }
+        }
+        return static_cast<int>(std::thread::hardware_concurrency());
+    }
+
+    void start() override {
+        create_fd();
+        set_non_blocking(sockfd); // A woken worker may find the connection already taken
+        cpu_placement placement = cpu_placement::configured();
+        for (int i = 0; i < num_workers_; ++i) {
+            pid_t child_pid = fork();
+            if (child_pid < 0) {
+                std::cerr << "Error forking process." << std::endl;
+            } else if (child_pid == 0) {
+                // Child process
+                prctl(PR_SET_PDEATHSIG, SIGTERM);
+                placement.pin_current_process(i);
+                work_process(i);
+                _exit(EXIT_FAILURE); // The reactor only returns on failure
+            } else {
+                worker_pids_.push_back(child_pid); // Store the worker PID
+            }
+        }
+        std::cout << "Prefork server started on port " << _port
+                  << " with " << worker_pids_.size() << " workers" << std::endl;
+
+        // Nothing to do but reap the workers
+        while (!worker_pids_.empty()) {
+            pid_t pid = waitpid(-1, nullptr, 0);
+            if (pid < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            std::erase(worker_pids_, pid);
+            std::cerr << "Worker " << pid << " exited." << std::endl;
+        }
+    }
+
+    void stop() {
+        for (pid_t pid : worker_pids_) {
+            kill(pid, SIGTERM); // Send termination signal to each worker
+        }
+        worker_pids_.clear();
+    }
+
+private:
+    void work_process(int index) {
+        try {
+            epoll_event_handler reactor(_port); // Own event loop and connection table
+            reactor.serve_shared(sockfd);
+        } catch (const std::exception& e) {
+            std::cerr << "Worker " << index << " failed: " << e.what() << std::endl;
+        }
+    }
+
+    int num_workers_;
+    std::vector<pid_t> worker_pids_;
+};
+
+#endif // PREFORK_SERVER_H
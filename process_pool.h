@@ -5,6 +5,8 @@
 #include <signal.h>
 #include <sys/wait.h>
 #include <vector>
+#include <chrono>
+#include "shared_stats.h"
 
 #define NUM_WORKERS 5 // Number of worker processes in the pool
 #include <unistd.h>
@@ -16,28 +18,33 @@ class processPool : public Socket {
         void start();
         void create_pool();
         void stop();
-        void work_process(); // Function to be executed by each worker process
+        void work_process(size_t index); // Function to be executed by each worker process
 
     private:
         void clean_child(int);
         std::vector<pid_t>  worker_pids; // Vector to hold worker process IDs
+        shared_stats stats{NUM_WORKERS}; // Mapped before fork(), dumped on SIGUSR1
 };
 processPool::processPool(int port) : Socket(port) {
     // Constructor implementation
     signal(SIGCHLD, [](int){ while (waitpid(-1, NULL, WNOHANG) > 0); });
     signal(SIGINT, processPool::signal_handler);
     signal(SIGTERM, processPool::signal_handler);
+    shared_stats::install_dump_signal();
 }
 
-void processPool::work_process() {
+void processPool::work_process(size_t index) {
     // This function will be executed by each worker process
+    shared_stats::worker_stats& my_stats = stats.claim(index);
     while (true) {
         int client_fd = accept_connection();
         if (client_fd < 0) {
             std::cerr << "Error accepting connection." << std::endl;
             continue;
         }
+        auto begin = std::chrono::steady_clock::now();
         handleconnections(client_fd); // Handle the connection
+        my_stats.record(std::chrono::steady_clock::now() - begin);
     }
 }
 
@@ -52,7 +59,8 @@ void processPool::create_pool() {
             std::cerr << "Error forking process." << std::endl;
         } else if (child_pid == 0) {
             // Child process
-            work_process();
+            signal(SIGUSR1, SIG_IGN); // Only the parent dumps
+            work_process(i);
         }else{
             // Parent process
             worker_pids.push_back(child_pid); // Store the worker PID
@@ -80,6 +88,11 @@ void processPool::start() {
     // Call the base class method to create the socket
     Socket::create_fd();
     create_pool(); // Create the worker process pool
-    // Accept connections or handle other tasks here
-
+    // Stay around to report the workers' statistics
+    while (true) {
+        pause(); // Wait for signals
+        if (shared_stats::take_dump_request()) {
+            stats.dump(std::cout);
+        }
+    }
 }
@@ -4,17 +4,30 @@
 #include   "socket.h"
 #include <signal.h>
 #include <sys/wait.h>
+#include <sys/select.h> // for pselect
 #include <vector>
 #include <sys/prctl.h>  // for prctl, PR_SET_PDEATHSIG
 #include <signal.h>     // for SIGTERM
+#include <chrono>
+#include <fstream>
+#include <string>
+#include "shared_stats.h"
 
 
 #define NUM_WORKERS 5 // Number of worker processes in the pool
 #include <unistd.h>
 
+// The parent is a supervisor: it sleeps until a signal arrives and then
+//   SIGCHLD         - reaps workers and respawns them (with backoff if they keep dying at startup)
+//   SIGUSR2         - reload: execs the binary found on disk with the listener fd passed
+//                     in PROCESSPOOL_LISTEN_FD; the new master starts its workers on the
+//                     same socket and sends SIGQUIT back, so no queued connection is lost
+//   SIGQUIT         - graceful stop: workers finish the request in hand and exit, then the master
+//   SIGINT/SIGTERM  - immediate stop
+//   SIGUSR1         - prints per-worker request counts and latencies (a new master starts from zero)
 class processPool1 : public Socket {
     public:
-        processPool1(int port);
+        processPool1(int port, int num_workers = NUM_WORKERS);
         ~processPool1() {
             stop(); // Ensure the server is stopped when the object is destroyed
         }
@@ -26,14 +39,54 @@ class processPool1 : public Socket {
         void work_process(); // Function to be executed by each worker process
 
     private:
-        std::vector<pid_t>  worker_pids; // Vector to hold worker process IDs
+        struct worker_slot {
+            pid_t pid = -1;
+            std::chrono::steady_clock::time_point started;
+            std::chrono::steady_clock::time_point respawn_at; // Earliest restart once pid is -1
+            std::chrono::milliseconds backoff{0};
+        };
+        static constexpr const char* listen_fd_env = "PROCESSPOOL_LISTEN_FD";
+        static constexpr std::chrono::seconds min_uptime{1}; // Dying sooner counts as a startup failure
+        static constexpr std::chrono::milliseconds max_backoff{5000};
+        static constexpr std::chrono::seconds drain_timeout{30}; // Then draining workers get SIGTERM
+
+        bool adopt_listener();
+        void spawn_worker(size_t index);
+        void reap_workers();
+        void supervise();
+        void reload();
+        void begin_drain();
+        size_t live_workers() const;
+        static void install_handler(int signum, void (*handler)(int));
+        static void worker_signal_handler(int signum);
+
+        std::vector<worker_slot> workers; // One slot per worker index
+        cpu_placement placement = cpu_placement::configured();
+        sigset_t original_mask; // Signal mask before the supervisor blocked its signals
+        pid_t reload_pid = -1; // New master started by reload(), -1 if none
+        bool inherited_listener = false; // Started by another master's reload()
+        bool draining = false;
+        std::chrono::steady_clock::time_point drain_deadline;
+        shared_stats stats{workers.size()}; // Slot per worker index, kept across respawns
+
+        inline static volatile sig_atomic_t child_exited = 0;
+        inline static volatile sig_atomic_t reload_requested = 0;
+        inline static volatile sig_atomic_t drain_requested = 0;
+        inline static volatile sig_atomic_t shutdown_requested = 0;
+        inline static volatile sig_atomic_t worker_draining = 0; // Worker side of SIGQUIT
+        inline static int worker_listen_fd = -1;
+        size_t worker_index = 0; // Set in the worker after fork()
 };
 
-processPool1::processPool1(int port) : Socket(port) {
+processPool1::processPool1(int port, int num_workers) : Socket(port), workers(num_workers > 0 ? num_workers : 1) {
     // Constructor implementation
-    signal(SIGCHLD, [](int){ while (waitpid(-1, NULL, WNOHANG) > 0); });
-    signal(SIGINT, processPool1::signal_handler);
-    signal(SIGTERM, processPool1::signal_handler);
+    install_handler(SIGCHLD, processPool1::signal_handler);
+    install_handler(SIGINT, processPool1::signal_handler);
+    install_handler(SIGTERM, processPool1::signal_handler);
+    install_handler(SIGQUIT, processPool1::signal_handler);
+    install_handler(SIGUSR2, processPool1::signal_handler);
+    shared_stats::install_dump_signal();
+    sigemptyset(&original_mask);
     //set the process group ID to the process ID
     pid_t pid = getpid();
     if (setpgid(pid, pid) < 0) {
@@ -41,55 +94,276 @@ processPool1::processPool1(int port) : Socket(port) {
         exit(EXIT_FAILURE);
     }
 }
+
+// No SA_RESTART: a blocked accept() or pselect() must return EINTR
+void processPool1::install_handler(int signum, void (*handler)(int)) {
+    struct sigaction sa = {};
+    sa.sa_handler = handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(signum, &sa, nullptr);
+}
+
 void processPool1::work_process() {
     // This function will be executed by each worker process
-    while (true) {
-        int client_fd = accept_connection();
+    shared_stats::worker_stats& my_stats = stats.claim(worker_index);
+    while (!worker_draining) {
+        int client_fd = accept(sockfd, nullptr, nullptr);
         if (client_fd < 0) {
-            std::cerr << "Error accepting connection." << std::endl;
-            continue;
+            if (errno != EINTR && !worker_draining) {
+                std::cerr << "Error accepting connection." << std::endl;
+            }
+            continue; // Draining shows up as EINTR or, once the listener is closed, EBADF
         }
+        auto begin = std::chrono::steady_clock::now();
         handleconnections(client_fd); // Handle the connection
+        my_stats.record(std::chrono::steady_clock::now() - begin);
     }
 }
 
+// Runs in a worker: stop accepting, finish the connection in hand. Closing our copy
+// of the listener also covers a signal that lands just before accept() is entered.
+void processPool1::worker_signal_handler(int) {
+    worker_draining = 1;
+    close(worker_listen_fd);
+}
+
+void processPool1::spawn_worker(size_t index) {
+    pid_t child_pid = fork();
+    if (child_pid < 0) {
+        std::cerr << "Error forking process." << std::endl;
+        workers[index].respawn_at = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        return;
+    }
+    if (child_pid == 0) {
+        // Child process
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        signal(SIGCHLD, SIG_DFL);
+        signal(SIGUSR2, SIG_DFL);
+        signal(SIGUSR1, SIG_IGN); // Only the supervisor dumps
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        worker_listen_fd = sockfd;
+        worker_index = index;
+        install_handler(SIGQUIT, processPool1::worker_signal_handler);
+        sigprocmask(SIG_SETMASK, &original_mask, nullptr);
+        placement.pin_current_process(index);
+        work_process();
+        _exit(EXIT_SUCCESS);
+    }
+    // Parent process
+    workers[index].pid = child_pid;
+    workers[index].started = std::chrono::steady_clock::now();
+}
+
 void processPool1::create_pool() {
-    // This function can be used to create a pool of worker processes
-    // For simplicity, we will not implement a full pool here
     std::cout << "Process pool created." << std::endl;
-    for (size_t i = 0; i < NUM_WORKERS; i++)
+    for (size_t i = 0; i < workers.size(); i++)
     {
-        pid_t child_pid = fork();
-        if (child_pid < 0) {
-            std::cerr << "Error forking process." << std::endl;
-        } else if (child_pid == 0) {
-            // Child process
-            prctl(PR_SET_PDEATHSIG, SIGTERM);
-            work_process();
-        } else {
-            // Parent process
-            worker_pids.push_back(child_pid); // Store the worker PID
+        spawn_worker(i);
+    }
+}
+
+size_t processPool1::live_workers() const {
+    size_t count = 0;
+    for (const worker_slot& slot : workers) {
+        count += slot.pid > 0;
+    }
+    return count;
+}
+
+void processPool1::reap_workers() {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        if (pid == reload_pid) {
+            // The new master only exits early if it could not start
+            std::cerr << "Reload failed: new master " << pid << " exited." << std::endl;
+            reload_pid = -1;
+            continue;
+        }
+        auto now = std::chrono::steady_clock::now();
+        for (worker_slot& slot : workers) {
+            if (slot.pid != pid) {
+                continue;
+            }
+            slot.pid = -1;
+            if (draining || shutdown_requested) {
+                break;
+            }
+            if (WIFSIGNALED(status)) {
+                std::cerr << "Worker " << pid << " killed by signal " << WTERMSIG(status) << ", respawning." << std::endl;
+            } else {
+                std::cerr << "Worker " << pid << " exited with status " << WEXITSTATUS(status) << ", respawning." << std::endl;
+            }
+            // A worker that dies at startup would otherwise be forked in a tight loop
+            if (now - slot.started < min_uptime) {
+                slot.backoff = std::min(max_backoff, std::max(std::chrono::milliseconds(100), slot.backoff * 2));
+            } else {
+                slot.backoff = std::chrono::milliseconds(0);
+            }
+            slot.respawn_at = now + slot.backoff;
+            break;
         }
     }
 }
 
+void processPool1::reload() {
+    if (reload_pid > 0) {
+        std::cerr << "Reload already in progress." << std::endl;
+        return;
+    }
+    // Our own command line; argv[0] is resolved again so a replaced binary is picked up
+    std::ifstream cmdline("/proc/self/cmdline", std::ios::binary);
+    std::vector<std::string> args;
+    for (std::string arg; std::getline(cmdline, arg, '\0');) {
+        args.push_back(arg);
+    }
+    if (args.empty()) {
+        std::cerr << "Reload failed: cannot read /proc/self/cmdline." << std::endl;
+        return;
+    }
+    int flags = fcntl(sockfd, F_GETFD);
+    if (flags < 0 || fcntl(sockfd, F_SETFD, flags & ~FD_CLOEXEC) < 0) {
+        perror("fcntl listener");
+        return;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Reload failed: fork." << std::endl;
+        return;
+    }
+    if (pid == 0) {
+        std::vector<char*> argv;
+        for (std::string& arg : args) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+        setenv(listen_fd_env, std::to_string(sockfd).c_str(), 1);
+        sigprocmask(SIG_SETMASK, &original_mask, nullptr);
+        execvp(argv[0], argv.data());
+        perror("execvp");
+        _exit(127);
+    }
+    reload_pid = pid;
+    std::cout << "Reloading: started new master " << pid << "." << std::endl;
+}
+
+void processPool1::begin_drain() {
+    draining = true;
+    drain_deadline = std::chrono::steady_clock::now() + drain_timeout;
+    for (const worker_slot& slot : workers) {
+        if (slot.pid > 0) {
+            kill(slot.pid, SIGQUIT);
+        }
+    }
+    std::cout << "Draining " << live_workers() << " workers." << std::endl;
+}
+
+void processPool1::supervise() {
+    while (true) {
+        if (child_exited) {
+            child_exited = 0;
+            reap_workers();
+        }
+        if (shutdown_requested) {
+            return;
+        }
+        if (shared_stats::take_dump_request()) {
+            stats.dump(std::cout);
+        }
+        if (reload_requested) {
+            reload_requested = 0;
+            reload();
+        }
+        if (drain_requested && !draining) {
+            begin_drain();
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (draining) {
+            if (live_workers() == 0) {
+                std::cout << "All workers drained." << std::endl;
+                return;
+            }
+            if (now >= drain_deadline) {
+                std::cerr << "Drain timed out, stopping the remaining workers." << std::endl;
+                return;
+            }
+        }
+
+        // Restart dead workers that are due; sleep until the next one or a signal
+        auto wake_at = draining ? drain_deadline : std::chrono::steady_clock::time_point::max();
+        for (size_t i = 0; i < workers.size() && !draining; ++i) {
+            if (workers[i].pid > 0) {
+                continue;
+            }
+            if (workers[i].respawn_at <= now) {
+                spawn_worker(i);
+            }
+            if (workers[i].pid < 0) {
+                wake_at = std::min(wake_at, workers[i].respawn_at);
+            }
+        }
+        struct timespec timeout;
+        struct timespec* timeout_ptr = nullptr;
+        if (wake_at != std::chrono::steady_clock::time_point::max()) {
+            auto remaining = std::max(std::chrono::nanoseconds(0), wake_at - std::chrono::steady_clock::now());
+            timeout.tv_sec = std::chrono::duration_cast<std::chrono::seconds>(remaining).count();
+            timeout.tv_nsec = (remaining - std::chrono::seconds(timeout.tv_sec)).count();
+            timeout_ptr = &timeout;
+        }
+        // Signals are only unblocked inside pselect, so none can slip in between the checks and the wait
+        pselect(0, nullptr, nullptr, nullptr, timeout_ptr, &original_mask);
+    }
+}
+
 void processPool1::signal_handler(int signum) {
-    // Handle signals like SIGINT and SIGTERM
-    std::cout << "Received signal: " << signum << ". Stopping the server." << std::endl;
-    killpg(getpgrp(), SIGTERM);  // Kill the entire process group
-    exit(0);
+    // Runs in the supervisor, which acts on the flags in supervise()
+    switch (signum) {
+        case SIGCHLD: child_exited = 1; break;
+        case SIGUSR2: reload_requested = 1; break;
+        case SIGQUIT: drain_requested = 1; break;
+        default: shutdown_requested = 1; break;
+    }
 }
 
 void processPool1::stop() {
     // Stop the server and clean up resources
-    for (pid_t pid : worker_pids) {
-        kill(pid, SIGTERM); // Send termination signal to each worker
+    for (worker_slot& slot : workers) {
+        if (slot.pid > 0) {
+            kill(slot.pid, SIGTERM); // Send termination signal to each worker
+            slot.pid = -1;
+        }
     }
-    worker_pids.clear();
     std::cout << "Server stopped." << std::endl;
 }
 
+// A listener handed over by reload() of the previous master
+bool processPool1::adopt_listener() {
+    const char* env = std::getenv(listen_fd_env);
+    if (!env) {
+        return false;
+    }
+    int fd = -1;
+    try {
+        fd = std::stoi(env);
+    } catch (const std::logic_error&) {
+    }
+    unsetenv(listen_fd_env); // Not for our own reloads or anything else we exec
+    int listening = 0;
+    socklen_t len = sizeof(listening);
+    if (fd < 0 || getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &len) < 0 || !listening) {
+        std::cerr << "Ignoring " << listen_fd_env << "=" << env << ": not a listening socket." << std::endl;
+        return false;
+    }
+    sockfd = fd;
+    std::cout << "Adopted listener fd " << fd << " from the previous master." << std::endl;
+    return true;
+}
+
 void processPool1::create_socket() {
+    if ((inherited_listener = adopt_listener())) {
+        return;
+    }
 
     sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (sockfd < 0) {
@@ -116,9 +390,18 @@ void processPool1::create_socket() {
 
 void processPool1::start() {
     create_socket(); // Create the socket
+    // Hold the supervisor's signals until it waits for them in supervise()
+    sigset_t blocked;
+    sigemptyset(&blocked);
+    for (int signum : {SIGCHLD, SIGINT, SIGTERM, SIGQUIT, SIGUSR1, SIGUSR2}) {
+        sigaddset(&blocked, signum);
+    }
+    sigprocmask(SIG_BLOCK, &blocked, &original_mask);
     create_pool(); // Create the worker pool
     std::cout << "Process pool started." << std::endl;
-    while (true) {
-        pause(); // Wait for signals
+    if (inherited_listener) {
+        // Our workers are accepting on the same socket: the old master can drain now
+        kill(getppid(), SIGQUIT);
     }
-}
\ No newline at end of file
+    supervise(); // Returns on SIGINT/SIGTERM or once drained, the destructor stops what is left
+}
@@ -0,0 +1,110 @@
+#ifndef REACTOR_SERVER_H
+#define REACTOR_SERVER_H
+
+#include "socket.h"
+#include "event_dispatcher.h"
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+#include <cstring>
+
+// Level-triggered reactor that runs on whatever backend the factory hands out.
+// With EventType::AUTO that is the fastest one the running kernel supports;
+// pollserver is this class pinned to EventType::Poll.
+class reactor_event_handler : public Socket {
+public:
+    reactor_event_handler(int port = 8080, EventType type = EventType::AUTO) : Socket(port) {
+        event_loop = EventLoopFactory::create_event_loop(type);
+        if (!event_loop) {
+            throw std::runtime_error("Failed to create event loop");
+        }
+    }
+
+    ~reactor_event_handler() override {
+        std::cout << "reactor_event_handler destructor called." << std::endl;
+    }
+
+    void start() override {
+        create_fd();
+        set_non_blocking(get_fd());
+        std::cout << "Socket started on port " << _port << std::endl;
+        event_loop->register_handler(sockfd,
+                                        EventIOType::READ,
+                                        std::make_shared<client_event_handler>(
+                                            event_loop.get(),
+                                            [this](int) {
+                                                handle_connections(); // Handle the connection
+                                            }));
+
+        event_loop->loop(); // Start the event loop
+    }
+
+private:
+    std::unique_ptr<Eventloop> event_loop; // Backend chosen by EventLoopFactory
+
+    void clientconnections(int clientfd, http_connection& connection) {
+        char buffer[1024];
+        int bytes_read = read(clientfd, buffer, sizeof(buffer));
+        if (bytes_read > 0) {
+            // Connection: close, so only the first complete request is answered
+            http_parser::status result = connection.consume(std::string_view(buffer, bytes_read),
+                                                            [](const http_parser::request&) { return false; });
+            if (result == http_parser::status::incomplete) {
+                return; // Wait for the rest of the request
+            }
+            // Simple HTTP response
+            const char* response =
+                "HTTP/1.1 200 OK\r\n"
+                "Content-Type: text/html\r\n"
+                "Content-Length: 13\r\n"
+                "Connection: close\r\n"
+                "\r\n"
+                "Hello, World!";
+            if (result == http_parser::status::error) {
+                response = bad_request_response;
+            }
+            int bytes_written = write(clientfd, response, strlen(response));
+            if (bytes_written < 0) {
+                std::cerr << "Error writing to client_fd: " << clientfd << std::endl;
+            }
+        } else if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return; // Spurious wakeup, keep polling
+        } else if (bytes_read < 0) {
+            perror("read error");
+        }
+        // Unregisters and closes the fd once dispatch is done
+        event_loop->close_fd_safely(clientfd);
+    }
+
+    void handle_connections() {
+        // Drain the accept queue, the listener is only reported once per wakeup
+        while (true) {
+            int client_fd = accept(sockfd, nullptr, nullptr);
+            if (client_fd < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    perror("accept error");
+                }
+                return;
+            }
+            set_non_blocking(client_fd); // Set the client socket to non-blocking mode
+
+            // Parser state lives as long as the handler registered for this fd
+            auto connection = std::make_shared<http_connection>();
+            try {
+                event_loop->register_handler(client_fd,
+                                                EventIOType::READ,
+                                                std::make_shared<client_event_handler>(
+                                                    event_loop.get(),
+                                                    [this, connection](int fd) {
+                                                        clientconnections(fd, *connection); // Handle the connection
+                                                    }));
+            } catch (const std::invalid_argument& e) {
+                // The backend cannot watch this fd (select beyond FD_SETSIZE), drop the connection
+                std::cerr << "Rejecting client_fd " << client_fd << ": " << e.what() << std::endl;
+                close(client_fd);
+            }
+        }
+    }
+};
+
+#endif // REACTOR_SERVER_H
@@ -0,0 +1,230 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstdlib>      // For std::getenv
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Preformatted responses keyed by request path. Every entry holds its complete
+// status line and headers, once with Connection: keep-alive and once with
+// Connection: close, so answering a request is one hash lookup and no formatting.
+// Files up to inline_limit also carry their body in the same blob (one write);
+// larger ones keep an open descriptor and the body is sent with sendfile, so
+// it never passes through user space.
+//
+// Without a root directory every path gets the built-in "Hello, World!" page,
+// which is what all servers answered before. The cache is filled once at startup
+// (before any worker thread or process exists) and is read-only afterwards.
+class response_cache {
+public:
+    // What to send for one request: head, then file_size bytes of file_fd if it is >= 0
+    struct response {
+        std::string_view head;
+        int file_fd = -1;
+        size_t file_size = 0;
+    };
+
+    static constexpr size_t default_inline_limit = 65536;
+
+    // Process-wide cache, loaded from $STATIC_ROOT the first time it is used
+    static response_cache& global() {
+        static response_cache cache(std::getenv("STATIC_ROOT"));
+        return cache;
+    }
+
+    explicit response_cache(const char* root = nullptr) {
+        fallback_ = make_entry(200, "OK", "text/html", "Hello, World!");
+        not_found_ = make_entry(404, "Not Found", "text/plain", "Not Found");
+        if (root && *root) {
+            load_directory(root);
+        }
+    }
+    ~response_cache() {
+        for (auto& [path, e] : entries_) {
+            if (e.owns_fd && e.file_fd >= 0) {
+                close(e.file_fd);
+            }
+        }
+    }
+    response_cache(const response_cache&) = delete;
+    response_cache& operator=(const response_cache&) = delete;
+
+    // Serve every regular file below root as "/<relative path>"; a directory's
+    // index.html also answers "/<dir>/". Returns the number of files loaded.
+    size_t load_directory(const std::string& root, size_t inline_limit = default_inline_limit) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        fs::path base = fs::canonical(root, ec);
+        if (ec || !fs::is_directory(base, ec)) {
+            std::cerr << "Static root " << root << " is not a directory." << std::endl;
+            return 0;
+        }
+        has_root_ = true;
+        size_t loaded = 0;
+        for (auto it = fs::recursive_directory_iterator(base, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (!it->is_regular_file(ec)) {
+                continue;
+            }
+            std::string path = "/" + it->path().lexically_relative(base).generic_string();
+            if (!add_file(path, it->path().string(), inline_limit)) {
+                continue;
+            }
+            ++loaded;
+            if (it->path().filename() == "index.html") {
+                store(path.substr(0, path.size() - std::string_view("index.html").size()), entries_.at(path).alias());
+            }
+        }
+        std::cout << "Response cache: " << loaded << " files from " << base.string() << std::endl;
+        return loaded;
+    }
+
+    // target may carry a query string, it is ignored
+    response lookup(std::string_view target, bool keep_alive) const {
+        const entry* e = &fallback_;
+        if (has_root_) {
+            target = target.substr(0, target.find_first_of("?#"));
+            auto it = entries_.find(target);
+            e = it != entries_.end() ? &it->second : &not_found_;
+        }
+        return response{keep_alive ? e->keep_alive_head : e->close_head, e->file_fd, e->file_size};
+    }
+
+    // Blocking send for the thread/process models; false on a write error
+    static bool send_blocking(int fd, const response& r) {
+        size_t written = 0;
+        while (written < r.head.size()) {
+            ssize_t n = write(fd, r.head.data() + written, r.head.size() - written);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            written += n;
+        }
+        off_t offset = 0;
+        while (r.file_fd >= 0 && static_cast<size_t>(offset) < r.file_size) {
+            ssize_t n = sendfile(fd, r.file_fd, &offset, r.file_size - offset);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    struct entry {
+        std::string keep_alive_head; // Headers (and inline body) with Connection: keep-alive
+        std::string close_head;      // The same with Connection: close
+        int file_fd = -1;            // Body sent with sendfile, -1 if inline
+        size_t file_size = 0;
+        bool owns_fd = true;         // false for an index alias sharing another entry's fd
+
+        entry alias() const {
+            return entry{keep_alive_head, close_head, file_fd, file_size, false};
+        }
+    };
+
+    // Heterogeneous lookup so a string_view target does not build a std::string
+    struct path_hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    static std::string head_for(int status, std::string_view reason, std::string_view type,
+                                size_t length, std::string_view connection) {
+        std::string head = "HTTP/1.1 " + std::to_string(status) + " ";
+        head.append(reason);
+        head.append("\r\nContent-Type: ");
+        head.append(type);
+        head.append("\r\nContent-Length: " + std::to_string(length) + "\r\nConnection: ");
+        head.append(connection);
+        head.append("\r\n\r\n");
+        return head;
+    }
+
+    static entry make_entry(int status, std::string_view reason, std::string_view type, std::string_view body) {
+        entry e;
+        e.keep_alive_head = head_for(status, reason, type, body.size(), "keep-alive");
+        e.keep_alive_head.append(body);
+        e.close_head = head_for(status, reason, type, body.size(), "close");
+        e.close_head.append(body);
+        return e;
+    }
+
+    static std::string_view content_type(const std::filesystem::path& file) {
+        static const std::unordered_map<std::string_view, std::string_view> types = {
+            {".html", "text/html"}, {".htm", "text/html"}, {".css", "text/css"},
+            {".js", "application/javascript"}, {".json", "application/json"},
+            {".txt", "text/plain"}, {".xml", "application/xml"}, {".svg", "image/svg+xml"},
+            {".png", "image/png"}, {".jpg", "image/jpeg"}, {".jpeg", "image/jpeg"},
+            {".gif", "image/gif"}, {".ico", "image/x-icon"}, {".pdf", "application/pdf"},
+        };
+        std::string ext = file.extension().string();
+        auto it = types.find(ext);
+        return it != types.end() ? it->second : std::string_view("application/octet-stream");
+    }
+
+    bool add_file(const std::string& path, const std::string& file, size_t inline_limit) {
+        struct stat st;
+        if (stat(file.c_str(), &st) < 0) {
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        std::string_view type = content_type(file);
+        if (size <= inline_limit) {
+            std::ifstream in(file, std::ios::binary);
+            std::string body((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (!in && !in.eof()) {
+                return false;
+            }
+            store(path, make_entry(200, "OK", type, body));
+            return true;
+        }
+        int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            perror("open");
+            return false;
+        }
+        entry e;
+        e.keep_alive_head = head_for(200, "OK", type, size, "keep-alive");
+        e.close_head = head_for(200, "OK", type, size, "close");
+        e.file_fd = fd;
+        e.file_size = size;
+        store(path, std::move(e));
+        return true;
+    }
+
+    // Insert or replace, closing the descriptor of a replaced entry
+    void store(const std::string& path, entry e) {
+        auto it = entries_.find(path);
+        if (it != entries_.end()) {
+            if (it->second.owns_fd && it->second.file_fd >= 0) {
+                close(it->second.file_fd);
+            }
+            it->second = std::move(e);
+            return;
+        }
+        entries_.emplace(path, std::move(e));
+    }
+
+    std::unordered_map<std::string, entry, path_hash, std::equal_to<>> entries_;
+    entry fallback_;   // Served for every path when there is no root
+    entry not_found_;  // Served for unknown paths when there is a root
+    bool has_root_ = false;
+};
+
+#endif // RESPONSE_CACHE_H
@@ -0,0 +1,94 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>    // For std::rotate
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+// Fixed-capacity byte ring used as a connection's receive buffer. The socket is
+// read straight into the free space (both halves when it wraps, one readv), so
+// there is no intermediate copy, and the memory per connection never grows.
+// peek() hands out the unread bytes as one contiguous view: when they happen to
+// wrap around the end they are rotated to the front first, which only occurs for
+// a request straddling the boundary. An empty ring rewinds to offset 0, so the
+// usual request/response pattern never wraps at all.
+class ring_buffer {
+public:
+    explicit ring_buffer(size_t capacity = 16384)
+                : capacity_(round_up_pow2(capacity)),
+                  mask_(capacity_ - 1),
+                  data_(new char[capacity_]) {}
+
+    ring_buffer(const ring_buffer&) = delete;
+    ring_buffer& operator=(const ring_buffer&) = delete;
+
+    size_t size() const { return static_cast<size_t>(tail_ - head_); }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return head_ == tail_; }
+    bool full() const { return size() == capacity_; }
+
+    // One readv into the free space. Returns what readv returned (0 if the ring is full).
+    ssize_t read_from(int fd) {
+        size_t free_bytes = capacity_ - size();
+        if (free_bytes == 0) {
+            return 0;
+        }
+        size_t start = static_cast<size_t>(tail_) & mask_;
+        size_t first = std::min(free_bytes, capacity_ - start);
+        struct iovec iov[2] = {
+            {data_.get() + start, first},
+            {data_.get(), free_bytes - first}, // Wrapped part, empty if the space is contiguous
+        };
+        ssize_t n = readv(fd, iov, iov[1].iov_len ? 2 : 1);
+        if (n > 0) {
+            tail_ += static_cast<size_t>(n);
+        }
+        return n;
+    }
+
+    // All unread bytes as one view, valid until the next read_from/consume
+    std::string_view peek() {
+        size_t start = static_cast<size_t>(head_) & mask_;
+        if (start + size() > capacity_) {
+            // Unread bytes wrap: rotate the storage so they start at offset 0
+            size_t count = size();
+            std::rotate(data_.get(), data_.get() + start, data_.get() + capacity_);
+            head_ = 0;
+            tail_ = count;
+            start = 0;
+        }
+        return std::string_view(data_.get() + start, size());
+    }
+
+    void consume(size_t n) {
+        head_ += std::min(n, size());
+        if (head_ == tail_) {
+            head_ = tail_ = 0; // Rewind so the next read starts contiguous
+        }
+    }
+
+    void clear() {
+        head_ = tail_ = 0;
+    }
+
+private:
+    static size_t round_up_pow2(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    size_t capacity_;
+    size_t mask_;
+    std::unique_ptr<char[]> data_;
+    uint64_t head_ = 0; // Read position, unbounded (index with mask_)
+    uint64_t tail_ = 0; // Write position, unbounded (index with mask_)
+};
+
+#endif // RING_BUFFER_H
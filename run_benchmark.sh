@@ -11,15 +11,22 @@ SERVER_PORT="8000"
 BENCH_CONNECTIONS="100000"
 BENCH_CONCURRENCY="100"
 BENCH_DURATION="5"
+BENCH_KEEPALIVE="${BENCH_KEEPALIVE:-0}"  # 1: reuse connections (ab -k)
 RESULT_DIR="benchmark_results"
 
 # Server models to test
 declare -a MODELS=(
     "epollserver"
+    "multireactor"
+    "reactor"
     "selectserver"
+    "pollserver"
+    "iouringserver"
     "lead_follow"
     "poolthread"
+    "work_stealing"
     "processPool1"
+    "prefork"
     "singleSocket"
     "multiSocket"
     "multiThreadSocket"
@@ -140,7 +147,11 @@ run_benchmark() {
     fi
     
     # Run benchmark
-    print_info "Running benchmark: $HTTP_BENCH -n $BENCH_CONNECTIONS -c $BENCH_CONCURRENCY -t 10 -s $BENCH_DURATION 'http://${SERVER_HOST}:${SERVER_PORT}/'"
+    local keepalive_flag=""
+    if [ "$BENCH_KEEPALIVE" = "1" ]; then
+        keepalive_flag="-k"
+    fi
+    print_info "Running benchmark: $HTTP_BENCH $keepalive_flag -n $BENCH_CONNECTIONS -c $BENCH_CONCURRENCY -t 10 -s $BENCH_DURATION 'http://${SERVER_HOST}:${SERVER_PORT}/'"
     
     echo "=== Benchmark Results for $model ==="
     echo "Date: $(date)" >> "$result_file"
@@ -151,7 +162,7 @@ run_benchmark() {
     
     sleep 10
 
-    if $HTTP_BENCH -n $BENCH_CONNECTIONS -c $BENCH_CONCURRENCY -t 10 -s $BENCH_DURATION "http://${SERVER_HOST}:${SERVER_PORT}/" > "$result_file" 2>&1; then
+    if $HTTP_BENCH $keepalive_flag -n $BENCH_CONNECTIONS -c $BENCH_CONCURRENCY -t 10 -s $BENCH_DURATION "http://${SERVER_HOST}:${SERVER_PORT}/" > "$result_file" 2>&1; then
         print_success "Benchmark completed for model: $model"
     else
         print_error "Benchmark failed for model: $model"
@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include <sys/select.h> 
 #include "event_dispatcher.h"
+#include "output_queue.h"
 
 
 class select_event_handler : public Socket{
@@ -39,27 +40,53 @@ public:
 private:
 std::unique_ptr<Eventloop> select_event_loop; // Pointer to the select event loop
 
-    void clientconnections(int clientfd) {
+    // Parser and pending output of one client
+    struct select_connection {
+        http_connection http;
+        output_queue out;
+    };
+
+    void clientconnections(int clientfd, const std::shared_ptr<select_connection>& state) {
+        select_connection& connection = *state;
         char buffer[1024];
         // You can add your connection handling logic here
         int bytes_read = read(clientfd, buffer, sizeof(buffer));
         if (bytes_read > 0) {
-            // Simple HTTP response
-            const char* response = 
-                "HTTP/1.1 200 OK\r\n"
-                "Content-Type: text/html\r\n"
-                "Content-Length: 13\r\n"
-                "Connection: close\r\n"
-                "\r\n"
-                "Hello, World!";
-            // Write the response back to the client
-            int bytes_written = write(clientfd, response, strlen(response));
-            if (bytes_written < 0) {
-                std::cerr << "Error writing to client_fd: " << clientfd << std::endl;
+            // Connection: close, so only the first complete request is answered
+            response_cache::response response;
+            http_parser::status result = connection.http.consume(std::string_view(buffer, bytes_read),
+                                                                 [&response](const http_parser::request& request) {
+                                                                     response = response_cache::global().lookup(request.target, false);
+                                                                     return false;
+                                                                 });
+            if (result == http_parser::status::incomplete) {
+                return; // Wait for the rest of the request
+            }
+            if (result == http_parser::status::error) {
+                connection.out.append_static(bad_request_response, sizeof(bad_request_response) - 1);
             } else {
-                select_event_loop->unregister_handler(clientfd, EventIOType::READ); // Unregister the read handler
-                select_event_loop->close_fd_safely(clientfd); // Close the connection after handling
+                connection.out.append_static(response.head.data(), response.head.size());
+                connection.out.append_file(response.file_fd, 0, response.file_size);
+            }
+            // Nothing more is read from this client, only the response is left to send
+            select_event_loop->unregister_handler(clientfd, EventIOType::READ); // Unregister the read handler
+            output_queue::flush_result flushed = connection.out.flush(clientfd);
+            if (flushed == output_queue::flush_result::blocked) {
+                // Socket buffer full: finish from the write handler when select reports it writable
+                select_event_loop->register_handler(clientfd,
+                                                    EventIOType::WRITE,
+                                                    std::make_shared<client_event_handler>(
+                                                        select_event_loop.get(),
+                                                        nullptr,
+                                                        [this, state](int client_fd) {
+                                                            on_writable(client_fd, *state);
+                                                        }));
+                return;
+            }
+            if (flushed == output_queue::flush_result::error) {
+                std::cerr << "Error writing to client_fd: " << clientfd << std::endl;
             }
+            select_event_loop->close_fd_safely(clientfd); // Close the connection after handling
         } else {
             if (bytes_read == 0) {
                 std::cout << "Client " << clientfd << " disconnected." << std::endl;
@@ -73,6 +100,18 @@ std::unique_ptr<Eventloop> select_event_loop; // Pointer to the select event loo
         }
     }
 
+    void on_writable(int clientfd, select_connection& connection) {
+        output_queue::flush_result flushed = connection.out.flush(clientfd);
+        if (flushed == output_queue::flush_result::blocked) {
+            return; // Still more to send
+        }
+        if (flushed == output_queue::flush_result::error) {
+            std::cerr << "Error writing to client_fd: " << clientfd << std::endl;
+        }
+        select_event_loop->unregister_handler(clientfd, EventIOType::WRITE);
+        select_event_loop->close_fd_safely(clientfd);
+    }
+
     void handle_connections() {
         int client_fd = accept_connection();
         if (client_fd < 0) {
@@ -81,13 +120,21 @@ std::unique_ptr<Eventloop> select_event_loop; // Pointer to the select event loo
         }
         set_non_blocking(client_fd); // Set the client socket to non-blocking mode
 
-        select_event_loop->register_handler(client_fd, 
-                                            EventIOType::READ, 
-                                            std::make_shared<client_event_handler>(
-                                                select_event_loop.get(), 
-                                                [this](int client_fd) {
-                                                    clientconnections(client_fd); // Handle the connection
-                                                }));
+        // Parser and output state live as long as the handlers registered for this fd
+        auto connection = std::make_shared<select_connection>();
+        try {
+            select_event_loop->register_handler(client_fd, 
+                                                EventIOType::READ, 
+                                                std::make_shared<client_event_handler>(
+                                                    select_event_loop.get(), 
+                                                    [this, connection](int client_fd) {
+                                                        clientconnections(client_fd, connection); // Handle the connection
+                                                    }));
+        } catch (const std::invalid_argument& e) {
+            // Beyond FD_SETSIZE: select() cannot watch it, drop the connection
+            std::cerr << "Rejecting client_fd " << client_fd << ": " << e.what() << std::endl;
+            close(client_fd);
+        }
     }
 
 };
\ No newline at end of file
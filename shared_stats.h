@@ -0,0 +1,195 @@
+#ifndef SHARED_STATS_H
+#define SHARED_STATS_H
+
+#include <sys/mman.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>    // For std::min, std::max
+#include <atomic>
+#include <bit>          // For std::bit_width
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <new>          // For placement new
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+// Per-worker counters for the forking models, in one MAP_SHARED anonymous mapping
+// created before fork() so the parent sees what every worker records. Each worker
+// writes only its own slot, and slots are padded to whole cache lines, so the hot
+// path is a few relaxed loads and stores on a line no other process writes. No lock
+// and no read-modify-write is involved. The parent reads the slots at any time; a
+// snapshot may be a request behind, never torn.
+class shared_stats {
+public:
+    // Bucket b counts requests that took less than 2^b microseconds (b = 0: under 1us);
+    // the last bucket also takes everything slower
+    static constexpr size_t latency_buckets = 32;
+
+    struct alignas(64) worker_stats {
+        std::atomic<int32_t> pid{0}; // Last process that owned the slot
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> latency_sum_us{0};
+        std::atomic<uint64_t> latency_max_us{0};
+        std::atomic<uint64_t> histogram[latency_buckets] = {};
+
+        // Owner of the slot only
+        void record(std::chrono::steady_clock::duration latency) {
+            uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+            bump(requests, 1);
+            bump(latency_sum_us, us);
+            if (us > latency_max_us.load(std::memory_order_relaxed)) {
+                latency_max_us.store(us, std::memory_order_relaxed);
+            }
+            bump(histogram[std::min<size_t>(std::bit_width(us), latency_buckets - 1)], 1);
+        }
+
+    private:
+        // Single writer: a plain add published with a relaxed store, no locked instruction
+        static void bump(std::atomic<uint64_t>& counter, uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Counters are shared between processes");
+    static_assert(sizeof(worker_stats) % 64 == 0, "Slots must not share a cache line");
+
+    explicit shared_stats(size_t workers) : count_(workers ? workers : 1) {
+        size_ = count_ * sizeof(worker_stats);
+        void* region = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (region == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "Failed to map shared stats");
+        }
+        slots_ = static_cast<worker_stats*>(region);
+        for (size_t i = 0; i < count_; ++i) {
+            new (&slots_[i]) worker_stats();
+        }
+    }
+    ~shared_stats() {
+        munmap(slots_, size_); // Processes forked from us keep their own mapping
+    }
+    shared_stats(const shared_stats&) = delete;
+    shared_stats& operator=(const shared_stats&) = delete;
+
+    size_t size() const { return count_; }
+
+    // Slot of worker index; a worker claims it with claim() after fork()
+    worker_stats& worker(size_t index) { return slots_[index % count_]; }
+    worker_stats& claim(size_t index) {
+        worker_stats& slot = worker(index);
+        slot.pid.store(getpid(), std::memory_order_relaxed);
+        return slot;
+    }
+
+    // SIGUSR1 only sets a flag, the parent dumps from its own loop. No SA_RESTART, so a
+    // parent blocked in accept() or pause() gets EINTR and notices the request at once.
+    static void install_dump_signal() {
+        struct sigaction sa = {};
+        sa.sa_handler = [](int) { dump_flag() = 1; };
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGUSR1, &sa, nullptr);
+    }
+    static bool take_dump_request() {
+        if (!dump_flag()) {
+            return false;
+        }
+        dump_flag() = 0;
+        return true;
+    }
+
+    // Per-worker and aggregate table; imbalance is the busiest worker's count over the mean
+    void dump(std::ostream& out) const {
+        uint64_t total = 0;
+        uint64_t busiest = 0;
+        size_t active = 0;
+        for (size_t i = 0; i < count_; ++i) {
+            uint64_t requests = slots_[i].requests.load(std::memory_order_relaxed);
+            total += requests;
+            busiest = std::max(busiest, requests);
+            active += requests != 0;
+        }
+        if (total == 0) {
+            out << "no requests recorded" << std::endl;
+            return;
+        }
+        out << "worker     pid    requests  share%  mean(us)   p50(us)   p99(us)   max(us)" << std::endl;
+        summary all;
+        for (size_t i = 0; i < count_; ++i) {
+            summary one = read_slot(slots_[i]);
+            if (one.requests == 0) {
+                continue;
+            }
+            print_row(out, std::to_string(i), std::to_string(slots_[i].pid.load(std::memory_order_relaxed)), one, total);
+            all.merge(one);
+        }
+        print_row(out, "all", "-", all, total);
+        double mean = static_cast<double>(total) / active;
+        out << active << " active workers, imbalance " << std::fixed << std::setprecision(2)
+            << busiest / mean << " (busiest / mean)" << std::defaultfloat << std::endl;
+    }
+
+private:
+    static volatile sig_atomic_t& dump_flag() {
+        static volatile sig_atomic_t flag = 0;
+        return flag;
+    }
+
+    // Copy of one slot, or the sum of several
+    struct summary {
+        uint64_t requests = 0;
+        uint64_t sum_us = 0;
+        uint64_t max_us = 0;
+        uint64_t histogram[latency_buckets] = {};
+
+        void merge(const summary& other) {
+            requests += other.requests;
+            sum_us += other.sum_us;
+            max_us = std::max(max_us, other.max_us);
+            for (size_t b = 0; b < latency_buckets; ++b) {
+                histogram[b] += other.histogram[b];
+            }
+        }
+        // Upper bound of the bucket that holds the given fraction of requests, capped at the maximum
+        uint64_t percentile_us(double fraction) const {
+            uint64_t target = static_cast<uint64_t>(requests * fraction);
+            uint64_t seen = 0;
+            for (size_t b = 0; b < latency_buckets; ++b) {
+                seen += histogram[b];
+                if (seen > target) {
+                    return std::min(uint64_t(1) << b, max_us);
+                }
+            }
+            return max_us;
+        }
+    };
+
+    static summary read_slot(const worker_stats& slot) {
+        summary one;
+        one.requests = slot.requests.load(std::memory_order_relaxed);
+        one.sum_us = slot.latency_sum_us.load(std::memory_order_relaxed);
+        one.max_us = slot.latency_max_us.load(std::memory_order_relaxed);
+        for (size_t b = 0; b < latency_buckets; ++b) {
+            one.histogram[b] = slot.histogram[b].load(std::memory_order_relaxed);
+        }
+        return one;
+    }
+
+    static void print_row(std::ostream& out, const std::string& name, const std::string& pid,
+                          const summary& row, uint64_t total) {
+        out << std::setw(6) << name << std::setw(8) << pid
+            << std::setw(12) << row.requests
+            << std::setw(8) << std::fixed << std::setprecision(1) << 100.0 * row.requests / total << std::defaultfloat
+            << std::setw(10) << (row.requests ? row.sum_us / row.requests : 0)
+            << std::setw(10) << row.percentile_us(0.5)
+            << std::setw(10) << row.percentile_us(0.99)
+            << std::setw(10) << row.max_us << std::endl;
+    }
+
+    size_t count_;
+    size_t size_;
+    worker_stats* slots_ = nullptr;
+};
+
+#endif // SHARED_STATS_H
@@ -0,0 +1,58 @@
+#ifndef SLOT_ALLOCATOR_H
+#define SLOT_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-size index allocator with an intrusive free list: next_[i] holds the next
+// free index while i is free, so allocate() and release() are a single pop/push
+// regardless of the table size. Freed slots are reused LIFO, which keeps the hot
+// part of whatever table the indices refer to small and cache-resident.
+class slot_allocator {
+public:
+    explicit slot_allocator(uint32_t capacity) : next_(capacity) {
+        for (uint32_t i = 0; i < capacity; ++i) {
+            next_[i] = i + 1 < capacity ? i + 1 : end_of_list;
+        }
+        head_ = capacity ? 0 : end_of_list;
+    }
+
+    // Returns a free index, or -1 when every slot is taken
+    int allocate() {
+        if (head_ == end_of_list) {
+            return -1;
+        }
+        uint32_t idx = head_;
+        head_ = next_[idx];
+        next_[idx] = in_use;
+        ++used_;
+        return static_cast<int>(idx);
+    }
+
+    // Out-of-range indices and double frees are ignored
+    void release(int idx) {
+        if (!is_allocated(idx)) {
+            return;
+        }
+        next_[idx] = head_;
+        head_ = static_cast<uint32_t>(idx);
+        --used_;
+    }
+
+    bool is_allocated(int idx) const {
+        return idx >= 0 && static_cast<size_t>(idx) < next_.size() && next_[idx] == in_use;
+    }
+    uint32_t capacity() const { return static_cast<uint32_t>(next_.size()); }
+    uint32_t used() const { return used_; }
+
+private:
+    static constexpr uint32_t end_of_list = UINT32_MAX;
+    static constexpr uint32_t in_use = UINT32_MAX - 1;
+
+    std::vector<uint32_t> next_; // Free: next free index, allocated: in_use
+    uint32_t head_;              // First free index
+    uint32_t used_ = 0;
+};
+
+#endif // SLOT_ALLOCATOR_H
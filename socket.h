@@ -10,16 +10,24 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
 #include <queue>
 #include <functional>
 #include <vector>
+#include <span>
+#include <algorithm>    // For std::min
 #include <sys/epoll.h>
 #ifndef SOCKET_H
 #define SOCKET_H
+#include "http_parser.h"
+#include "response_cache.h"
+#include "inline_task.h"
+#include "cpu_affinity.h"
 class Socket {
     public:
         // Constructor that initializes the socket with a default port
-        Socket( int port = 8080): _port(port), is_running(false), sockfd(-1), addr{} { }
+        Socket( int port = 8080, bool reuse_port = false): _port(port), is_running(false), sockfd(-1), addr{}, reuse_port(reuse_port) { }
 
         bool is_created() const {
             return is_running;
@@ -57,6 +65,10 @@ class Socket {
 
             // Set the socket to allow reuse of the address
             setoption(SO_REUSEADDR, 1);
+            if (reuse_port) {
+                // Let several listeners share the port, the kernel balances new connections among them
+                setoption(SO_REUSEPORT, 1);
+            }
             // Bind the socket to the address and port
             if (bind(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
                 close(sockfd);
@@ -68,6 +80,12 @@ class Socket {
                 close(sockfd);
                 throw std::runtime_error("Failed to listen on socket");
             }
+            if (reuse_port && incoming_cpu >= 0) {
+                // Prefer this listener for connections whose packets are processed on incoming_cpu
+                if (setsockopt(sockfd, SOL_SOCKET, SO_INCOMING_CPU, &incoming_cpu, sizeof(incoming_cpu)) < 0) {
+                    perror("setsockopt SO_INCOMING_CPU");
+                }
+            }
             std::cout << "Socket:" << sockfd << " created and listening on port " << _port << std::endl;
         }
         // Set the socket to non-blocking mode
@@ -82,6 +100,11 @@ class Socket {
                 throw std::runtime_error("Failed to set socket to non-blocking mode");
             }
         }
+        // CPU this reuseport listener serves (SO_INCOMING_CPU), -1 for no preference.
+        // Must be set before create_fd().
+        void set_incoming_cpu(int cpu) {
+            incoming_cpu = cpu;
+        }
         int get_fd(void) const {
             if (!is_created()) {
                 throw std::runtime_error("Socket not created");
@@ -118,67 +141,105 @@ class Socket {
                     // No connections available, return -1
                     std::cerr << "No connections available, returning -1." << std::endl;
                     return -1;
+                } else if (errno == EINTR) {
+                    return -1; // A signal handler ran, errno tells the caller
                 } else {
                     throw std::runtime_error("Failed to accept connection");
                 }
             }
             return client_sockfd;
         }
+        // Blocking request handling for the thread/process models: read until one
+        // request is complete, answer it and close (Connection: close)
         void handleconnections(int clientfd) {
-            int buffer[1024];
-            // You can add your connection handling logic here
-            int bytes_read = read(clientfd, buffer, sizeof(buffer));
-            if (bytes_read > 0) {
-                // Simple HTTP response
-                const char* response = 
-                    "HTTP/1.1 200 OK\r\n"
-                    "Content-Type: text/html\r\n"
-                    "Content-Length: 13\r\n"
-                    "Connection: close\r\n"
-                    "\r\n"
-                    "Hello, World!";
+            char buffer[4096];
+            http_connection connection;
+            http_parser::status result = http_parser::status::incomplete;
+            response_cache::response response;
+            while (result == http_parser::status::incomplete) {
+                ssize_t bytes_read = read(clientfd, buffer, sizeof(buffer));
+                if (bytes_read < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (bytes_read < 0) {
+                    std::cerr << "Error reading from client_fd: " << clientfd << std::endl;
+                    break;
+                }
+                if (bytes_read == 0) {
+                    break; // Peer closed before sending a full request
+                }
+                result = connection.consume(std::string_view(buffer, bytes_read),
+                                            [&response](const http_parser::request& request) {
+                                                response = response_cache::global().lookup(request.target, false);
+                                                return false;
+                                            });
+            }
+            if (result == http_parser::status::error) {
+                response = response_cache::response{std::string_view(bad_request_response, sizeof(bad_request_response) - 1)};
+            }
+            if (result != http_parser::status::incomplete) {
                 // Write the response back to the client
-                int bytes_written = write(clientfd, response, strlen(response));
-                if (bytes_written < 0) {
+                if (!response_cache::send_blocking(clientfd, response)) {
                     std::cerr << "Error writing to client_fd: " << clientfd << std::endl;
-                } else {
-                    close(clientfd); // Close the connection after handling
                 }
-            } else if (bytes_read < 0) {
-                std::cerr << "Error reading from client_fd: " << clientfd << std::endl;
-            } else {
-                close(clientfd);
             }
+            close(clientfd); // Close the connection after handling
         }
 
     protected:
+        // Sent before dropping a connection whose request could not be parsed
+        static constexpr char bad_request_response[] =
+            "HTTP/1.1 400 Bad Request\r\n"
+            "Content-Length: 0\r\n"
+            "Connection: close\r\n"
+            "\r\n";
+
         int sockfd;
         int _port;
         int is_running = 1; // Flag to indicate if the socket is running
         struct sockaddr_in addr;
+        bool reuse_port = false; // Bind with SO_REUSEPORT so every listener gets its own accept queue
+        int incoming_cpu = -1; // SO_INCOMING_CPU of a reuseport listener, -1 if unset
 };
 
 class threadpool{
     public:
-        threadpool(int _num_cpus = std::thread::hardware_concurrency()) : num_cpus(_num_cpus),stop(false) {
+        // Elastic mode: instead of a fixed count, workers are added while tasks wait
+        // longer than grow_above in the queue and retire after idle_timeout without
+        // work once the smoothed delay is back under shrink_below. The gap between
+        // the two thresholds plus the idle timeout keeps the size from oscillating.
+        struct elastic_config {
+            size_t min_threads = 1;
+            size_t max_threads = 64;
+            std::chrono::microseconds grow_above{1000};
+            std::chrono::microseconds shrink_below{200};
+            std::chrono::milliseconds idle_timeout{2000};
+            std::chrono::milliseconds sample_interval{10}; // How often the queue is checked for growth
+        };
+
+        threadpool(int _num_cpus = std::thread::hardware_concurrency(),
+                   const cpu_placement& placement = cpu_placement::configured())
+                    : num_cpus(_num_cpus), stop(false), placement(placement) {
+            std::unique_lock<std::mutex> lock(mutex);
             for (size_t i = 0; i < num_cpus; i++)
             {
-                threads.emplace_back([this] {
-                    while (true){
-                        std::function<void()> task;
-                            {
-                                std::unique_lock<std::mutex> lock(mutex);
-                                condition.wait(lock, [this] { return !tasks.empty() || stop; });
-                                if (stop && tasks.empty()) {
-                                    return; // Exit the thread if stop is true and no tasks are left
-                                }
-                                task = std::move(tasks.front());
-                                tasks.pop();
-                            }
-                            task(); // Execute the task
-                    }
-                });
+                add_worker();
+            }
+        }
+        explicit threadpool(const elastic_config& config,
+                            const cpu_placement& placement = cpu_placement::configured())
+                    : num_cpus(static_cast<int>(std::max<size_t>(config.min_threads, 1))),
+                      stop(false), placement(placement), elastic(true), config(config) {
+            this->config.min_threads = num_cpus;
+            this->config.max_threads = std::max(this->config.max_threads, this->config.min_threads);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                for (size_t i = 0; i < this->config.min_threads; i++)
+                {
+                    add_worker();
+                }
             }
+            monitor = std::thread([this] { monitor_loop(); });
         }
         ~threadpool() {
             {
@@ -186,11 +247,17 @@ class threadpool{
                 stop = true; // Set the stop flag to true
             }
             condition.notify_all(); // Notify all threads to wake up and exit
+            monitor_condition.notify_all();
+            if (monitor.joinable()) {
+                monitor.join();
+            }
+            // No worker can retire or be added any more, the lists are stable
             for (std::thread &t : threads) {
                 if (t.joinable()) {
                     t.join(); // Wait for all threads to finish
                 }
             }
+            join_retired();
         }
 
 // Enqueue a new task to be executed by the thread pool
@@ -198,18 +265,183 @@ class threadpool{
         void enqueue(F&& f) {
             {
                 std::unique_lock<std::mutex> lock(mutex);
-                tasks.emplace(std::forward<F>(f)); // Add the task to the queue
+                tasks.emplace(std::forward<F>(f), stamp()); // Add the task to the queue
             }
             condition.notify_one(); // Notify one thread to wake up and execute the task
         }
 
+// Enqueue a burst under a single lock acquisition. Each woken worker drains up to
+// drain_batch tasks, so only as many workers are notified as the burst needs.
+        template<typename F>
+        void enqueue_bulk(std::span<F> batch) {
+            if (batch.empty()) {
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                uint64_t now = stamp();
+                for (F& f : batch) {
+                    tasks.emplace(std::move(f), now);
+                }
+            }
+            size_t wake = (batch.size() + drain_batch - 1) / drain_batch;
+            if (wake >= live_workers.load(std::memory_order_relaxed)) {
+                condition.notify_all();
+                return;
+            }
+            for (size_t i = 0; i < wake; ++i) {
+                condition.notify_one();
+            }
+        }
+
+// Current number of workers and the smoothed time tasks spent queued (elastic mode only)
+        size_t size() const { return live_workers.load(std::memory_order_relaxed); }
+        std::chrono::microseconds queue_delay() const {
+            return std::chrono::microseconds(delay_ewma_ns.load(std::memory_order_relaxed) / 1000);
+        }
+
     private:
+        static constexpr size_t drain_batch = 16; // Most tasks a worker takes per wakeup
+
+        static uint64_t now_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+        // Enqueue time, only read in elastic mode so the fixed pool skips the clock
+        uint64_t stamp() const {
+            return elastic ? now_ns() : 0;
+        }
+
+        // Called with mutex held
+        void add_worker() {
+            size_t index = next_worker_index++;
+            live_workers.fetch_add(1, std::memory_order_relaxed);
+            threads.emplace_back([this] { worker_loop(); });
+            placement.pin_thread(threads.back(), index);
+        }
+
+        void worker_loop() {
+            inline_task batch[drain_batch];
+            while (true){
+                size_t count = 0;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        auto ready = [this] { return !tasks.empty() || stop; };
+                        if (!elastic) {
+                            condition.wait(lock, ready);
+                        } else if (!condition.wait_for(lock, config.idle_timeout, ready)) {
+                            if (should_retire()) {
+                                retire_self();
+                                return;
+                            }
+                            continue;
+                        }
+                        if (stop && tasks.empty()) {
+                            return; // Exit the thread if stop is true and no tasks are left
+                        }
+                        // Take a fair share of the backlog, up to drain_batch, in this one acquisition
+                        size_t workers = live_workers.load(std::memory_order_relaxed);
+                        size_t share = (tasks.size() + workers - 1) / workers;
+                        count = std::min(share, drain_batch);
+                        uint64_t queued_at = 0;
+                        for (size_t i = 0; i < count; ++i) {
+                            batch[i] = tasks.pop(&queued_at);
+                        }
+                        if (elastic) {
+                            record_delay(now_ns() - queued_at); // Delay of the youngest task taken
+                        }
+                    }
+                    for (size_t i = 0; i < count; ++i) {
+                        batch[i](); // Execute the task
+                        batch[i] = inline_task(); // Release what the closure holds right away
+                    }
+            }
+        }
+
+        // Called with mutex held. EWMA with weight 1/8 per sample.
+        void record_delay(uint64_t delay_ns) {
+            int64_t ewma = static_cast<int64_t>(delay_ewma_ns.load(std::memory_order_relaxed));
+            ewma += (static_cast<int64_t>(delay_ns) - ewma) / 8;
+            delay_ewma_ns.store(static_cast<uint64_t>(ewma), std::memory_order_relaxed);
+        }
+
+        // Called with mutex held by a worker that timed out waiting for work
+        bool should_retire() const {
+            return !stop && live_workers.load(std::memory_order_relaxed) > config.min_threads
+                   && queue_delay() < config.shrink_below;
+        }
+
+        // Called with mutex held: hand our own std::thread to the monitor to join
+        void retire_self() {
+            auto self = std::find_if(threads.begin(), threads.end(),
+                                     [](const std::thread& t) { return t.get_id() == std::this_thread::get_id(); });
+            if (self != threads.end()) {
+                retired.push_back(std::move(*self));
+                threads.erase(self);
+            }
+            size_t left = live_workers.fetch_sub(1, std::memory_order_relaxed) - 1;
+            std::cout << "threadpool: shrank to " << left << " workers" << std::endl;
+        }
+
+        void join_retired() {
+            std::vector<std::thread> done;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                done.swap(retired);
+            }
+            for (std::thread& t : done) {
+                t.join();
+            }
+        }
+
+        // Elastic mode: grows the pool while the oldest queued task has waited too long.
+        // Blocked workers stop dequeuing, so the age of the queue head is what reveals
+        // them; the EWMA only moves when tasks are actually taken.
+        void monitor_loop() {
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    if (monitor_condition.wait_for(lock, config.sample_interval, [this] { return stop; })) {
+                        return;
+                    }
+                    if (tasks.empty()) {
+                        // Nothing waiting: decay the estimate so an old burst does not block shrinking
+                        delay_ewma_ns.store(delay_ewma_ns.load(std::memory_order_relaxed) / 2,
+                                            std::memory_order_relaxed);
+                    } else {
+                        uint64_t head_age = now_ns() - tasks.front_stamp();
+                        size_t workers = live_workers.load(std::memory_order_relaxed);
+                        if (head_age > static_cast<uint64_t>(config.grow_above.count()) * 1000
+                            && workers < config.max_threads) {
+                            // Grow by a quarter (at least one) per sample
+                            size_t add = std::min(std::max<size_t>(workers / 4, 1), config.max_threads - workers);
+                            for (size_t i = 0; i < add; ++i) {
+                                add_worker();
+                            }
+                            std::cout << "threadpool: grew to " << workers + add << " workers (oldest task waited "
+                                      << head_age / 1000 << " us)" << std::endl;
+                        }
+                    }
+                }
+                join_retired();
+            }
+        }
+
         std::vector<std::thread> threads; // Vector to hold worker threads
+        std::vector<std::thread> retired; // Workers that exited, waiting to be joined
         int num_cpus;
         bool stop = false; // Flag to indicate if the thread pool is stopping
         std::condition_variable condition; // Condition variable for thread synchronization
         std::mutex mutex; // Mutex for protecting the task queue
-        std::queue<std::function<void()>> tasks; // Queue to hold tasks for the thread pool
+        task_queue tasks; // Queue to hold tasks for the thread pool, closures stored inline
+        cpu_placement placement;
+        bool elastic = false;
+        elastic_config config;
+        std::thread monitor; // Elastic mode only
+        std::condition_variable monitor_condition;
+        size_t next_worker_index = 0; // Placement index of the next worker
+        std::atomic<size_t> live_workers{0};
+        std::atomic<uint64_t> delay_ewma_ns{0}; // Smoothed queueing delay
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,167 @@
+#ifndef THREAD_CACHE_H
+#define THREAD_CACHE_H
+
+#include <pthread.h>
+#include <limits.h>     // For PTHREAD_STACK_MIN
+#include <unistd.h>
+#include <algorithm>    // For std::max
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <utility>      // For std::move, std::forward
+#include <vector>
+#include "inline_task.h"
+
+// Thread-per-task without the unbounded thread creation. A finished thread parks
+// and the next submission is handed straight to the most recently parked one (its
+// stack and caches are still warm), so a steady connection rate creates no threads
+// at all. New threads are only started while every live thread is busy, never
+// more than max_threads, and get a small stack instead of the 8 MB default;
+// beyond the cap tasks queue until a thread finishes. Parked threads beyond
+// max_idle, or parked for longer than idle_timeout, exit.
+class thread_cache {
+public:
+    struct config {
+        size_t max_threads = 256;       // Hard cap on live threads
+        size_t max_idle = 32;           // Parked threads kept for reuse
+        size_t stack_size = 256 * 1024; // Per thread, rounded up to the system minimum
+        std::chrono::milliseconds idle_timeout{10000};
+    };
+
+    thread_cache() : thread_cache(config{}) {}
+    explicit thread_cache(const config& cfg) : config_(cfg) {
+        config_.max_threads = std::max<size_t>(config_.max_threads, 1);
+        config_.stack_size = std::max<size_t>(config_.stack_size, PTHREAD_STACK_MIN);
+    }
+    ~thread_cache() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+        for (parked_thread* parked : idle_) {
+            parked->wakeup.notify_one();
+        }
+        // Threads are detached; wait until the last one has left run()
+        all_exited_.wait(lock, [this] { return live_ == 0; });
+    }
+    thread_cache(const thread_cache&) = delete;
+    thread_cache& operator=(const thread_cache&) = delete;
+
+    template<typename F>
+    void submit(F&& f) {
+        submit_task(inline_task(std::forward<F>(f)));
+    }
+
+    // Snapshot for logging
+    size_t live() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return live_;
+    }
+    size_t queued() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pending_.size();
+    }
+
+private:
+    // Lives on the parked thread's stack
+    struct parked_thread {
+        std::condition_variable wakeup;
+        inline_task task;
+        bool has_task = false;
+    };
+    struct start_args {
+        thread_cache* cache;
+        inline_task first;
+    };
+
+    void submit_task(inline_task&& task) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            parked_thread* parked = idle_.back();
+            idle_.pop_back();
+            parked->task = std::move(task);
+            parked->has_task = true;
+            // Notified under the lock: once it is released the thread may run, time out and exit
+            parked->wakeup.notify_one();
+            return;
+        }
+        if (live_ < config_.max_threads) {
+            if (spawn(task)) {
+                return;
+            }
+            if (live_ == 0) {
+                lock.unlock();
+                task(); // No thread at all: run it here rather than queue it forever
+                return;
+            }
+        }
+        pending_.push(std::move(task)); // At the cap, the next thread to finish picks it up
+    }
+
+    // Called with mutex_ held; task is left untouched when no thread could be created
+    bool spawn(inline_task& task) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        pthread_attr_setstacksize(&attr, config_.stack_size);
+        start_args* args = new start_args{this, std::move(task)};
+        pthread_t thread;
+        int ret = pthread_create(&thread, &attr, &thread_cache::thread_main, args);
+        pthread_attr_destroy(&attr);
+        if (ret != 0) {
+            std::cerr << "Failed to start connection thread: " << strerror(ret) << std::endl;
+            task = std::move(args->first);
+            delete args;
+            return false;
+        }
+        ++live_;
+        return true;
+    }
+
+    static void* thread_main(void* arg) {
+        start_args* args = static_cast<start_args*>(arg);
+        thread_cache* cache = args->cache;
+        inline_task task = std::move(args->first);
+        delete args;
+        cache->run(std::move(task));
+        return nullptr;
+    }
+
+    void run(inline_task task) {
+        parked_thread self;
+        while (true) {
+            task();
+            task = inline_task(); // Drop the finished closure before parking
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!pending_.empty()) {
+                task = pending_.pop();
+                continue;
+            }
+            if (!stopping_ && idle_.size() < config_.max_idle) {
+                self.has_task = false;
+                idle_.push_back(&self);
+                self.wakeup.wait_for(lock, config_.idle_timeout, [&] { return self.has_task || stopping_; });
+                if (self.has_task) {
+                    task = std::move(self.task);
+                    continue;
+                }
+                std::erase(idle_, &self); // Timed out or stopping, nobody may hand us work now
+            }
+            if (--live_ == 0) {
+                all_exited_.notify_all();
+            }
+            return;
+        }
+    }
+
+    config config_;
+    mutable std::mutex mutex_;
+    std::condition_variable all_exited_;
+    std::vector<parked_thread*> idle_; // LIFO: the back was parked last
+    task_queue pending_;               // Submitted while max_threads were busy
+    size_t live_ = 0;
+    bool stopping_ = false;
+};
+
+#endif // THREAD_CACHE_H
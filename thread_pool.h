@@ -3,10 +3,13 @@
 #include   <cstdlib>
 #include   "socket.h"
 #include    <thread>
+#include   <poll.h>
+#include   <cstdio>
+#include   <memory>
 
 class poolthread: public Socket {
     public:
-        poolthread(int port) : Socket(port) {
+        poolthread(int port) : Socket(port), threadpool_instance(make_pool()) {
             signal(SIGINT, poolthread::signal_handler);
             signal(SIGTERM, poolthread::signal_handler);
         }
@@ -19,23 +22,58 @@ class poolthread: public Socket {
         void start() {
             // Call the base class method to create the socket
             Socket::create_fd();
-            //accept connections or handle other tasks here
+            // Non-blocking listener: after each wakeup every pending connection is
+            // accepted and the whole burst goes to the pool in one enqueue_bulk
+            set_non_blocking(sockfd);
             std::cout << "Thread pool server started on port " << _port << std::endl;
+            std::vector<inline_task> burst;
+            burst.reserve(max_burst);
+            struct pollfd listener = {sockfd, POLLIN, 0};
             while (true) {
-                int client_fd = accept_connection();
-                if (client_fd < 0) {
-                    std::cerr << "Error accepting connection." << std::endl;
-                    continue; // Continue to accept more connections
+                if (poll(&listener, 1, -1) < 0) {
+                    if (errno != EINTR) {
+                        perror("poll error");
+                    }
+                    continue;
                 }
-                // Handle the connection in a new thread
-                threadpool_instance.enqueue([client_fd, this]() {
-                    handleconnections(client_fd); // Handle the connection
-                });
+                while (burst.size() < max_burst) {
+                    int client_fd = accept(sockfd, nullptr, nullptr);
+                    if (client_fd < 0) {
+                        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                            perror("accept error");
+                        }
+                        break;
+                    }
+                    // Handle the connection on a pool thread
+                    burst.emplace_back([client_fd, this]() {
+                        handleconnections(client_fd); // Handle the connection
+                    });
+                }
+                threadpool_instance->enqueue_bulk(std::span<inline_task>(burst));
+                burst.clear();
             }
         }
 
     private:
-        threadpool threadpool_instance;
+        static constexpr size_t max_burst = 64; // Connections handed over per enqueue_bulk
+        std::unique_ptr<threadpool> threadpool_instance;
+
+        // $THREADPOOL_ELASTIC="min:max" sizes the pool by queueing delay between
+        // min and max workers; otherwise one worker per CPU as before
+        static std::unique_ptr<threadpool> make_pool() {
+            const char* spec = std::getenv("THREADPOOL_ELASTIC");
+            if (!spec || !*spec) {
+                return std::make_unique<threadpool>();
+            }
+            threadpool::elastic_config config;
+            if (sscanf(spec, "%zu:%zu", &config.min_threads, &config.max_threads) != 2
+                || config.min_threads == 0 || config.max_threads < config.min_threads) {
+                throw std::invalid_argument(std::string("THREADPOOL_ELASTIC must be min:max, got ") + spec);
+            }
+            std::cout << "Elastic thread pool: " << config.min_threads << " to " << config.max_threads
+                      << " workers" << std::endl;
+            return std::make_unique<threadpool>(config);
+        }
 
 };
 
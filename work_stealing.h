@@ -0,0 +1,328 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>      // For std::move, std::forward
+#include <vector>
+#include "inline_task.h"
+#include "mpsc_queue.h"
+
+// Chase-Lev work-stealing deque (Le et al., "Correct and Efficient Work-Stealing
+// for Weak Memory Models"). The owning thread pushes and pops at the bottom
+// without any read-modify-write except when racing a thief for the last element;
+// other threads steal from the top with one CAS. The array doubles when full;
+// retired arrays are kept until the deque dies since a thief may still read one.
+// T must be trivially copyable (the pool stores task node pointers).
+template <typename T>
+class chase_lev_deque {
+public:
+    explicit chase_lev_deque(size_t capacity = 256) {
+        size_t n = 1;
+        while (n < capacity) {
+            n <<= 1;
+        }
+        arrays_.push_back(std::make_unique<array>(n));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+    chase_lev_deque(const chase_lev_deque&) = delete;
+    chase_lev_deque& operator=(const chase_lev_deque&) = delete;
+
+    // Owner only
+    void push(T value) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        array* a = array_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(a->mask)) {
+            a = grow(a, t, b);
+        }
+        a->put(b, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only. Returns false when the deque is empty.
+    bool pop(T& out) {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed); // Was empty
+            return false;
+        }
+        out = a->get(b);
+        if (t == b) {
+            // Last element: a thief may be taking it too, the top CAS decides
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Any thread. Returns false when empty or when another thread won the race.
+    bool steal(T& out) {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        array* a = array_.load(std::memory_order_acquire);
+        T value = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return false;
+        }
+        out = value;
+        return true;
+    }
+
+    // Approximate when other threads are pushing or stealing concurrently
+    bool empty() const {
+        return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct array {
+        explicit array(size_t n) : mask(n - 1), slots(new std::atomic<T>[n]) {}
+        T get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T value) { slots[i & mask].store(value, std::memory_order_relaxed); }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    array* grow(array* old, int64_t t, int64_t b) {
+        arrays_.push_back(std::make_unique<array>((old->mask + 1) * 2));
+        array* a = arrays_.back().get();
+        for (int64_t i = t; i < b; ++i) {
+            a->put(i, old->get(i));
+        }
+        array_.store(a, std::memory_order_release);
+        return a;
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};    // Next element thieves take
+    alignas(64) std::atomic<int64_t> bottom_{0}; // Next free slot of the owner
+    std::atomic<array*> array_{nullptr};
+    std::vector<std::unique_ptr<array>> arrays_; // Current array plus retired ones, owner only
+};
+
+// Thread pool without a shared queue. enqueue() hands tasks round-robin to the
+// workers' inboxes (lock-free MPSC rings); each worker moves its inbox into its own
+// Chase-Lev deque and runs from the bottom, and a worker with nothing to do steals
+// from the top of the others' deques before parking. A parked worker sleeps on its
+// own futex word (std::atomic::wait), so a submission wakes exactly one thread.
+// Tasks are inline_tasks as in threadpool: the inbox holds them by value, and the
+// deque, which can only hand out trivially copyable values, holds nodes from a
+// pool owned by the worker that filled them, so enqueueing does not allocate.
+class work_stealing_pool {
+public:
+    explicit work_stealing_pool(size_t num_workers = std::thread::hardware_concurrency())
+                : workers_(num_workers ? num_workers : 1) {
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            workers_[i].thread = std::thread([this, i] { run(i); });
+        }
+    }
+    ~work_stealing_pool() {
+        stopping_.store(true, std::memory_order_seq_cst);
+        for (worker& w : workers_) {
+            w.state.store(running, std::memory_order_seq_cst);
+            w.state.notify_one();
+        }
+        for (worker& w : workers_) {
+            if (w.thread.joinable()) {
+                w.thread.join();
+            }
+        }
+    }
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    template<typename F>
+    void enqueue(F&& f) {
+        inline_task t(std::forward<F>(f));
+        size_t start = next_worker_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t attempt = 0;; ++attempt) {
+            worker& w = workers_[(start + attempt) % workers_.size()];
+            if (w.inbox.try_push(std::move(t))) {
+                wake(w);
+                return;
+            }
+            if (attempt % workers_.size() == workers_.size() - 1) {
+                std::this_thread::yield(); // Every inbox is full, let the workers catch up
+            }
+        }
+    }
+
+    size_t size() const { return workers_.size(); }
+
+private:
+    static constexpr uint32_t running = 0;
+    static constexpr uint32_t parked = 1;
+    static constexpr size_t inbox_capacity = 1024;
+    static constexpr size_t inbox_batch = 32; // Tasks moved from the inbox to the deque per refill
+
+    // A task parked in a deque. Only the owner worker takes nodes from its pool; a
+    // thief that ran one hands it back through the owner's returned list.
+    struct task_node {
+        inline_task fn;
+        task_node* next = nullptr; // Free list link
+        size_t owner = 0;          // Worker whose pool the node belongs to
+    };
+
+    struct alignas(64) worker {
+        chase_lev_deque<task_node*> deque;
+        mpsc_ring<inline_task> inbox{inbox_capacity};
+        std::atomic<uint32_t> state{running}; // Futex word the worker parks on
+        std::thread thread;
+        task_node* free_nodes = nullptr;            // Owner only
+        std::atomic<task_node*> returned{nullptr};  // Freed by thieves, taken whole by the owner
+        std::vector<std::unique_ptr<task_node>> nodes; // Every node of the pool, owner only
+    };
+
+    void run(size_t self) {
+        worker& w = workers_[self];
+        inline_task t;
+        task_node* node = nullptr;
+        while (true) {
+            if (w.deque.pop(node)) {
+                node->fn();
+                release_node(self, node);
+                continue;
+            }
+            if (refill(self, t)) {
+                t();
+                t = inline_task(); // Drop the closure before looking for more work
+                continue;
+            }
+            if (steal(self, node)) {
+                node->fn();
+                release_node(self, node);
+                continue;
+            }
+            if (stopping_.load(std::memory_order_acquire)) {
+                return; // Nothing left anywhere
+            }
+            park(self);
+        }
+    }
+
+    // Moves a batch from the inbox to the deque and returns one task to run now.
+    // If more than that one arrived, a parked peer is woken to steal the rest.
+    bool refill(size_t self, inline_task& out) {
+        worker& w = workers_[self];
+        if (!w.inbox.try_pop(out)) {
+            return false;
+        }
+        inline_task t;
+        size_t moved = 0;
+        while (moved < inbox_batch && w.inbox.try_pop(t)) {
+            task_node* node = acquire_node(self);
+            node->fn = std::move(t);
+            w.deque.push(node);
+            ++moved;
+        }
+        if (moved) {
+            wake_idle(self);
+        }
+        return true;
+    }
+
+    task_node* acquire_node(size_t self) {
+        worker& w = workers_[self];
+        if (!w.free_nodes) {
+            // Single consumer taking the whole list, so pushes need no ABA protection
+            w.free_nodes = w.returned.exchange(nullptr, std::memory_order_acquire);
+        }
+        if (task_node* node = w.free_nodes) {
+            w.free_nodes = node->next;
+            return node;
+        }
+        w.nodes.push_back(std::make_unique<task_node>());
+        w.nodes.back()->owner = self;
+        return w.nodes.back().get();
+    }
+
+    void release_node(size_t self, task_node* node) {
+        node->fn = inline_task(); // Drop the closure now, not when the node is reused
+        worker& owner = workers_[node->owner];
+        if (node->owner == self) {
+            node->next = owner.free_nodes;
+            owner.free_nodes = node;
+            return;
+        }
+        task_node* head = owner.returned.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!owner.returned.compare_exchange_weak(head, node, std::memory_order_release,
+                                                       std::memory_order_relaxed));
+    }
+
+    bool steal(size_t self, task_node*& out) {
+        for (size_t k = 1; k < workers_.size(); ++k) {
+            if (workers_[(self + k) % workers_.size()].deque.steal(out)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool has_work(size_t self) {
+        if (!workers_[self].inbox.empty()) {
+            return true;
+        }
+        for (const worker& w : workers_) {
+            if (!w.deque.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void park(size_t self) {
+        worker& w = workers_[self];
+        w.state.store(parked, std::memory_order_seq_cst);
+        // Pairs with the fence in wake(): either the submitter sees parked or we see its task
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (has_work(self) || stopping_.load(std::memory_order_seq_cst)) {
+            w.state.store(running, std::memory_order_relaxed);
+            return;
+        }
+        w.state.wait(parked, std::memory_order_acquire);
+    }
+
+    void wake(worker& w) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t expected = parked;
+        if (w.state.load(std::memory_order_relaxed) == parked &&
+            w.state.compare_exchange_strong(expected, running, std::memory_order_acq_rel)) {
+            w.state.notify_one();
+        }
+    }
+
+    void wake_idle(size_t self) {
+        for (size_t k = 1; k < workers_.size(); ++k) {
+            worker& w = workers_[(self + k) % workers_.size()];
+            uint32_t expected = parked;
+            if (w.state.load(std::memory_order_relaxed) == parked &&
+                w.state.compare_exchange_strong(expected, running, std::memory_order_acq_rel)) {
+                w.state.notify_one();
+                return;
+            }
+        }
+    }
+
+    std::vector<worker> workers_;
+    alignas(64) std::atomic<size_t> next_worker_{0}; // Round-robin cursor for enqueue()
+    std::atomic<bool> stopping_{false};
+};
+
+#endif // WORK_STEALING_H
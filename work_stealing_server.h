@@ -0,0 +1,40 @@
+#include   <signal.h>
+#include   <iostream>
+#include   <cstdlib>
+#include   "socket.h"
+#include   "work_stealing.h"
+
+// poolthread with the shared mutex/condition-variable queue replaced by the
+// work-stealing pool: the accept loop never takes a lock to hand off a connection
+class workstealing: public Socket {
+    public:
+        workstealing(int port) : Socket(port) {
+            signal(SIGINT, workstealing::signal_handler);
+            signal(SIGTERM, workstealing::signal_handler);
+        }
+
+        static void signal_handler(int signum) {
+            std::cout << "Signal received: " << signum << ". Shutting down gracefully." << std::endl;
+            exit(signum);
+        }
+
+        void start() {
+            Socket::create_fd();
+            std::cout << "Work-stealing server started on port " << _port
+                      << " with " << pool.size() << " workers" << std::endl;
+            while (true) {
+                int client_fd = accept_connection();
+                if (client_fd < 0) {
+                    std::cerr << "Error accepting connection." << std::endl;
+                    continue; // Continue to accept more connections
+                }
+                pool.enqueue([client_fd, this]() {
+                    handleconnections(client_fd); // Handle the connection
+                });
+            }
+        }
+
+    private:
+        work_stealing_pool pool;
+
+};